@@ -0,0 +1,146 @@
+// Compares the one-value-per-notification path against MTU-packed batches.
+//
+// What batching saves is notifications: each one costs a PropertiesChanged
+// signal through bluetoothd and a slot in a BLE connection event, which this
+// bench does not time. It reports how many notifications and wire bytes
+// (ATT header included) each path needs, and the notification rate at the
+// streaming sample rate. The encoder column is CPU time only and is not the
+// cost that matters: the single path is cheaper to encode but sends one
+// notification per sample.
+#include "MeasurementBatch.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+// Default sample rate of --stream (one sample every 100 ms)
+constexpr double kStreamSamplesPerSecond = 10.0;
+
+struct Result
+{
+    std::string name;
+    std::size_t notifications{0};
+    std::size_t wireBytes{0};
+    double seconds{0};
+};
+
+std::vector<MeasurementSample> makeSamples(std::size_t count)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> step(-50, 50);
+    std::uniform_int_distribution<int> jitter(-3, 3);
+
+    std::vector<MeasurementSample> samples;
+    samples.reserve(count);
+    std::uint32_t ts = 0;
+    std::int32_t milli = 45000;
+    for (std::size_t i = 0; i < count; ++i) {
+        ts += 100 + jitter(rng);
+        milli += step(rng);
+        samples.push_back({ts, milli});
+    }
+    return samples;
+}
+
+Result runSingle(const std::vector<MeasurementSample>& samples)
+{
+    Result r{"single (5 B/notify)"};
+    std::vector<std::uint8_t> data;
+    auto begin = std::chrono::steady_clock::now();
+    for (const auto& s : samples) {
+        encodeMeasurementValue(s.mantissa, -3, data);
+        ++r.notifications;
+        r.wireBytes += data.size() + kAttNotifyHeader;
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return r;
+}
+
+Result runBatched(const std::vector<MeasurementSample>& samples, std::size_t mtu, bool& roundTripOk)
+{
+    Result r{"batched mtu=" + std::to_string(mtu)};
+    MeasurementBatcher batcher(mtu, std::chrono::hours(1));
+    std::vector<std::uint8_t> data;
+    std::vector<std::vector<std::uint8_t>> sent;
+    sent.reserve(samples.size() / 4);
+
+    auto now = std::chrono::steady_clock::now();
+    auto begin = now;
+    for (const auto& s : samples) {
+        if (batcher.add(s, now, data)) {
+            ++r.notifications;
+            r.wireBytes += data.size() + kAttNotifyHeader;
+            sent.push_back(data);
+        }
+    }
+    if (batcher.flush(data)) {
+        ++r.notifications;
+        r.wireBytes += data.size() + kAttNotifyHeader;
+        sent.push_back(data);
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<MeasurementSample> decoded;
+    std::size_t next = 0;
+    roundTripOk = true;
+    for (const auto& payload : sent) {
+        if (payload.size() > batcher.payloadLimit() ||
+            !decodeMeasurementNotification(payload.data(), payload.size(), decoded)) {
+            roundTripOk = false;
+            break;
+        }
+        for (const auto& d : decoded) {
+            const auto& want = samples[next++];
+            if (d.timestampMs != want.timestampMs || d.mantissa != want.mantissa)
+                roundTripOk = false;
+        }
+    }
+    if (next != samples.size())
+        roundTripOk = false;
+    return r;
+}
+
+void print(const Result& r, std::size_t samples)
+{
+    double notifiesPerSecond = kStreamSamplesPerSecond * static_cast<double>(r.notifications) / static_cast<double>(samples);
+    std::cout << std::left << std::setw(22) << r.name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(3) << notifiesPerSecond
+              << std::setw(12) << r.notifications
+              << std::setw(12) << r.wireBytes
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << static_cast<double>(r.wireBytes) / samples
+              << std::setw(18) << static_cast<std::uint64_t>(samples / r.seconds) << "\n";
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    auto samples = makeSamples(count);
+
+    std::cout << std::left << std::setw(22) << "path" << std::right
+              << std::setw(12) << "notifies/s"
+              << std::setw(12) << "notifies"
+              << std::setw(12) << "wire B"
+              << std::setw(10) << "B/sample"
+              << std::setw(18) << "encode CPU smp/s" << "\n";
+
+    print(runSingle(samples), count);
+
+    bool ok = true;
+    for (std::size_t mtu : {23, 185, 247, 517}) {
+        bool roundTripOk = false;
+        print(runBatched(samples, mtu, roundTripOk), count);
+        if (!roundTripOk) {
+            std::cerr << "decode mismatch at mtu=" << mtu << "\n";
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
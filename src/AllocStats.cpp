@@ -0,0 +1,176 @@
+#include "AllocStats.h"
+#include "Logger.h"
+
+#if GATT_ALLOC_ACCOUNTING
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace {
+thread_local std::uint64_t tAllocCount = 0;
+thread_local std::uint64_t tAllocBytes = 0;
+
+struct HandlerStats
+{
+    const char* name;
+    std::uint64_t calls;
+    std::uint64_t allocs;
+    std::uint64_t bytes;
+    std::uint64_t violations;
+};
+
+// Fixed table so that recording never allocates itself
+constexpr std::size_t kMaxHandlers = 32;
+std::array<HandlerStats, kMaxHandlers> gHandlers{};
+std::size_t gHandlerCount = 0;
+std::mutex gHandlersMutex;
+
+void* countedAlloc(std::size_t size, std::size_t alignment)
+{
+    ++tAllocCount;
+    tAllocBytes += size;
+
+    if (size == 0)
+        size = 1;
+    void* p = nullptr;
+    if (alignment > alignof(std::max_align_t))
+        p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    else
+        p = std::malloc(size);
+    return p;
+}
+
+void record(const char* handler, std::uint64_t allocs, std::uint64_t bytes, bool expectNone)
+{
+    std::lock_guard<std::mutex> lock(gHandlersMutex);
+    HandlerStats* entry = nullptr;
+    for (std::size_t i = 0; i < gHandlerCount; ++i) {
+        if (gHandlers[i].name == handler || std::strcmp(gHandlers[i].name, handler) == 0) {
+            entry = &gHandlers[i];
+            break;
+        }
+    }
+    if (!entry) {
+        if (gHandlerCount == kMaxHandlers)
+            return;
+        entry = &gHandlers[gHandlerCount++];
+        entry->name = handler;
+    }
+
+    ++entry->calls;
+    entry->allocs += allocs;
+    entry->bytes += bytes;
+    if (expectNone && allocs > 0)
+        ++entry->violations;
+}
+} // namespace
+
+// ===========================================
+// Counting allocator
+// ===========================================
+void* operator new(std::size_t size)
+{
+    if (void* p = countedAlloc(size, 0))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* p = countedAlloc(size, static_cast<std::size_t>(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+// ===========================================
+// AllocScope Implementation
+// ===========================================
+AllocScope::AllocScope(const char* handler, bool expectNone)
+    : handler_(handler), expectNone_(expectNone), startCount_(tAllocCount), startBytes_(tAllocBytes)
+{
+}
+
+AllocScope::~AllocScope()
+{
+    record(handler_, tAllocCount - startCount_, tAllocBytes - startBytes_, expectNone_);
+}
+
+std::uint64_t AllocScope::allocations() const
+{
+    return tAllocCount - startCount_;
+}
+
+void reportAllocationStats()
+{
+    std::array<HandlerStats, kMaxHandlers> snapshot;
+    std::size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(gHandlersMutex);
+        snapshot = gHandlers;
+        count = gHandlerCount;
+    }
+
+    LOG_INFO("Allocation accounting (per handler):");
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& h = snapshot[i];
+        LOG_INFO("  ", h.name, ": calls=", h.calls, " allocs=", h.allocs, " bytes=", h.bytes,
+                 " allocs/call=", h.calls ? static_cast<double>(h.allocs) / h.calls : 0.0);
+        if (h.violations > 0)
+            LOG_WARNING("  ", h.name, " is expected to be allocation-free but allocated in ",
+                        h.violations, " of ", h.calls, " calls");
+    }
+}
+
+#else
+
+void reportAllocationStats()
+{
+}
+
+#endif
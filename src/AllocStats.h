@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-handler heap allocation accounting.
+//
+// Built with -DGATT_ALLOC_ACCOUNTING=ON, a counting operator new is linked in
+// and every AllocScope attributes the allocations made on its thread to the
+// named handler. Otherwise AllocScope compiles to nothing.
+#if GATT_ALLOC_ACCOUNTING
+
+class AllocScope
+{
+public:
+    // `handler` must be a string literal. With `expectNone`, any allocation
+    // inside the scope is reported as a violation.
+    explicit AllocScope(const char* handler, bool expectNone = false);
+    ~AllocScope();
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+    std::uint64_t allocations() const;
+
+private:
+    const char* handler_;
+    bool expectNone_;
+    std::uint64_t startCount_;
+    std::uint64_t startBytes_;
+};
+
+#else
+
+class AllocScope
+{
+public:
+    explicit AllocScope(const char*, bool = false) {}
+    std::uint64_t allocations() const { return 0; }
+};
+
+#endif
+
+// Logs calls, allocations and bytes per handler. No-op without GATT_ALLOC_ACCOUNTING.
+void reportAllocationStats();
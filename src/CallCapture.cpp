@@ -0,0 +1,468 @@
+#include "CallCapture.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+constexpr char kMagic[4] = {'G', 'C', 'A', 'P'};
+constexpr std::uint8_t kVersion = 4;
+
+// A capture must survive the process being killed (e.g. by the watchdog), so
+// the stream is flushed every so many records or at least once per interval
+constexpr std::uint64_t kFlushEveryRecords = 256;
+constexpr auto kFlushInterval = std::chrono::seconds(1);
+
+constexpr const char* kIfaceProperties = "org.freedesktop.DBus.Properties";
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+void putString(std::vector<std::uint8_t>& out, const std::string& s)
+{
+    putVarint(out, s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+std::uint64_t zigzag(std::int64_t v)
+{
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t v)
+{
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+bool getVarint(std::istream& in, std::uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int b = in.get();
+        if (b == std::char_traits<char>::eof())
+            return false;
+        v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool getString(std::istream& in, std::string& s)
+{
+    std::uint64_t len = 0;
+    if (!getVarint(in, len) || len > (1u << 20))
+        return false;
+    s.resize(len);
+    return static_cast<bool>(in.read(s.data(), static_cast<std::streamsize>(len)));
+}
+
+bool getBytes(std::istream& in, std::vector<std::uint8_t>& bytes)
+{
+    std::uint64_t len = 0;
+    if (!getVarint(in, len) || len > (1u << 20))
+        return false;
+    bytes.resize(len);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(len)));
+}
+
+// Upper bound for counts read from a capture, against corrupt files
+constexpr std::uint64_t kMaxCount = 1u << 20;
+// a{sv} nesting accepted when reading a capture
+constexpr int kMaxDictDepth = 8;
+
+template <typename T>
+struct Tag
+{
+    using type = T;
+};
+
+// Calls f(Tag<T>) for the C++ type of a basic D-Bus type code. Bool is left
+// out: arrays of it have no usable std::vector<bool> mapping.
+template <typename F>
+bool withBasicType(char code, F&& f)
+{
+    switch (code) {
+        case 'y': f(Tag<std::uint8_t>{}); return true;
+        case 'n': f(Tag<std::int16_t>{}); return true;
+        case 'q': f(Tag<std::uint16_t>{}); return true;
+        case 'i': f(Tag<std::int32_t>{}); return true;
+        case 'u': f(Tag<std::uint32_t>{}); return true;
+        case 'x': f(Tag<std::int64_t>{}); return true;
+        case 't': f(Tag<std::uint64_t>{}); return true;
+        case 'd': f(Tag<double>{}); return true;
+        case 's': f(Tag<std::string>{}); return true;
+        case 'o': f(Tag<sdbus::ObjectPath>{}); return true;
+        case 'g': f(Tag<sdbus::Signature>{}); return true;
+        default:  return false;
+    }
+}
+
+void putValue(std::vector<std::uint8_t>& out, bool v)
+{
+    out.push_back(v ? 1 : 0);
+}
+
+template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+void putValue(std::vector<std::uint8_t>& out, T v)
+{
+    if constexpr (std::is_signed_v<T>)
+        putVarint(out, zigzag(v));
+    else
+        putVarint(out, v);
+}
+
+void putValue(std::vector<std::uint8_t>& out, double v)
+{
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &v, sizeof(bits));
+    for (int i = 0; i < 8; ++i)
+        out.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+}
+
+void putValue(std::vector<std::uint8_t>& out, const std::string& v)
+{
+    putString(out, v);
+}
+
+bool getValue(std::istream& in, bool& v)
+{
+    std::uint64_t raw = 0;
+    if (!getVarint(in, raw) || raw > 1)
+        return false;
+    v = raw != 0;
+    return true;
+}
+
+template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+bool getValue(std::istream& in, T& v)
+{
+    std::uint64_t raw = 0;
+    if (!getVarint(in, raw))
+        return false;
+    if constexpr (std::is_signed_v<T>)
+        v = static_cast<T>(unzigzag(raw));
+    else
+        v = static_cast<T>(raw);
+    return true;
+}
+
+bool getValue(std::istream& in, double& v)
+{
+    std::uint8_t bytes[8];
+    if (!in.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+        return false;
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i)
+        bits |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+    std::memcpy(&v, &bits, sizeof(v));
+    return true;
+}
+
+bool getValue(std::istream& in, std::string& v)
+{
+    return getString(in, v);
+}
+
+std::string signatureOf(const sdbus::Variant& value)
+{
+    const char* type = value.peekValueType();
+    return type ? type : "";
+}
+
+bool encodeDict(const std::map<std::string, sdbus::Variant>& dict, std::vector<std::uint8_t>& out);
+
+// Appends `value` (of D-Bus type `sig`); false if the type cannot be captured
+bool encodeVariant(const sdbus::Variant& value, const std::string& sig, std::vector<std::uint8_t>& out)
+{
+    if (sig == "b") {
+        putValue(out, value.get<bool>());
+        return true;
+    }
+    if (sig.size() == 1) {
+        return withBasicType(sig[0], [&](auto tag) {
+            using T = typename decltype(tag)::type;
+            putValue(out, value.get<T>());
+        });
+    }
+    if (sig.size() == 2 && sig[0] == 'a') {
+        return withBasicType(sig[1], [&](auto tag) {
+            using T = typename decltype(tag)::type;
+            const auto elements = value.get<std::vector<T>>();
+            putVarint(out, elements.size());
+            for (const auto& e : elements)
+                putValue(out, e);
+        });
+    }
+    if (sig == "a{sv}")
+        return encodeDict(value.get<std::map<std::string, sdbus::Variant>>(), out);
+    return false;
+}
+
+bool encodeDict(const std::map<std::string, sdbus::Variant>& dict, std::vector<std::uint8_t>& out)
+{
+    putVarint(out, dict.size());
+    for (const auto& [key, value] : dict) {
+        auto sig = signatureOf(value);
+        putString(out, key);
+        putString(out, sig);
+        if (!encodeVariant(value, sig, out))
+            return false;
+    }
+    return true;
+}
+
+bool decodeVariant(std::istream& in, const std::string& sig, sdbus::Variant& value, int depth);
+
+bool decodeDict(std::istream& in, std::map<std::string, sdbus::Variant>& dict, int depth)
+{
+    std::uint64_t count = 0;
+    if (depth > kMaxDictDepth || !getVarint(in, count) || count > kMaxCount)
+        return false;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::string key;
+        std::string sig;
+        if (!getString(in, key) || !getString(in, sig) || !decodeVariant(in, sig, dict[key], depth + 1))
+            return false;
+    }
+    return true;
+}
+
+bool decodeVariant(std::istream& in, const std::string& sig, sdbus::Variant& value, int depth)
+{
+    bool ok = false;
+    if (sig == "b") {
+        bool v = false;
+        ok = getValue(in, v);
+        value = sdbus::Variant(v);
+    } else if (sig.size() == 1) {
+        withBasicType(sig[0], [&](auto tag) {
+            typename decltype(tag)::type v{};
+            ok = getValue(in, v);
+            value = sdbus::Variant(v);
+        });
+    } else if (sig.size() == 2 && sig[0] == 'a') {
+        withBasicType(sig[1], [&](auto tag) {
+            std::vector<typename decltype(tag)::type> elements;
+            std::uint64_t count = 0;
+            if (!getVarint(in, count) || count > kMaxCount)
+                return;
+            elements.resize(count);
+            for (auto& e : elements) {
+                if (!getValue(in, e))
+                    return;
+            }
+            ok = true;
+            value = sdbus::Variant(elements);
+        });
+    } else if (sig == "a{sv}") {
+        std::map<std::string, sdbus::Variant> dict;
+        ok = decodeDict(in, dict, depth);
+        value = sdbus::Variant(dict);
+    }
+    return ok;
+}
+} // namespace
+
+const char* interfaceNameOf(CallTarget target)
+{
+    switch (target) {
+        case CallTarget::Service:        return "org.bluez.GattService1";
+        case CallTarget::Characteristic: return "org.bluez.GattCharacteristic1";
+        case CallTarget::Advertisement:  return "org.bluez.LEAdvertisement1";
+        case CallTarget::Endpoint:       return "org.bluez.MediaEndpoint1";
+        case CallTarget::StreamCharacteristic: return "org.bluez.GattCharacteristic1";
+        default:                         return "";
+    }
+}
+
+const char* methodNameOf(CallMethod method)
+{
+    switch (method) {
+        case CallMethod::ReadValue:           return "ReadValue";
+        case CallMethod::WriteValue:          return "WriteValue";
+        case CallMethod::StartNotify:         return "StartNotify";
+        case CallMethod::StopNotify:          return "StopNotify";
+        case CallMethod::Release:             return "Release";
+        case CallMethod::SetConfiguration:    return "SetConfiguration";
+        case CallMethod::SelectConfiguration: return "SelectConfiguration";
+        case CallMethod::ClearConfiguration:  return "ClearConfiguration";
+        case CallMethod::PropertiesGet:       return "Get";
+        case CallMethod::PropertiesGetAll:    return "GetAll";
+        default:                              return "";
+    }
+}
+
+const char* interfaceNameOf(CallTarget target, CallMethod method)
+{
+    if (method == CallMethod::PropertiesGet || method == CallMethod::PropertiesGetAll)
+        return kIfaceProperties;
+    return interfaceNameOf(target);
+}
+
+std::map<std::string, sdbus::Variant> toOptions(const std::vector<CapturedOption>& options)
+{
+    std::map<std::string, sdbus::Variant> dict;
+    for (const auto& o : options) {
+        if (!o.lossy)
+            dict[o.key] = o.value;
+    }
+    return dict;
+}
+
+// ===========================================
+// CallRecorder Implementation
+// ===========================================
+bool CallRecorder::open(const std::string& filename, const std::vector<std::string>& targetPaths)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        LOG_ERROR("Failed to open capture file ", filename);
+        return false;
+    }
+
+    scratch_.assign(std::begin(kMagic), std::end(kMagic));
+    scratch_.push_back(kVersion);
+    for (std::size_t i = 0; i < static_cast<std::size_t>(CallTarget::Count); ++i)
+        putString(scratch_, i < targetPaths.size() ? targetPaths[i] : std::string{});
+    file_.write(reinterpret_cast<const char*>(scratch_.data()), static_cast<std::streamsize>(scratch_.size()));
+
+    last_ = std::chrono::steady_clock::now();
+    lastFlush_ = last_;
+    count_ = 0;
+    lossyOptions_ = 0;
+    loggedLossyTypes_.clear();
+    enabled_ = true;
+    LOG_INFO("Capturing incoming D-Bus calls to ", filename);
+    return true;
+}
+
+void CallRecorder::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_.exchange(false))
+        return;
+    file_.close();
+    LOG_INFO("Captured ", count_, " D-Bus calls");
+    if (lossyOptions_)
+        LOG_WARNING(lossyOptions_, " option(s) had types the capture cannot encode; those calls will not replay exactly");
+}
+
+void CallRecorder::record(CallTarget target, CallMethod method, const std::vector<std::uint8_t>& payload,
+                          const std::map<std::string, sdbus::Variant>* options, const std::string& objectPath,
+                          const std::string& property)
+{
+    if (!enabled_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_)
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    scratch_.clear();
+    putVarint(scratch_, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - last_).count()));
+    last_ = now;
+    scratch_.push_back(static_cast<std::uint8_t>(target));
+    scratch_.push_back(static_cast<std::uint8_t>(method));
+    putVarint(scratch_, payload.size());
+    scratch_.insert(scratch_.end(), payload.begin(), payload.end());
+    putString(scratch_, objectPath);
+    putString(scratch_, property);
+
+    putVarint(scratch_, options ? options->size() : 0);
+    if (options) {
+        for (const auto& [key, value] : *options) {
+            auto sig = signatureOf(value);
+            putString(scratch_, key);
+            putString(scratch_, sig);
+            auto mark = scratch_.size();
+            scratch_.push_back(1);
+            if (!encodeVariant(value, sig, scratch_)) {
+                scratch_.resize(mark);
+                scratch_.push_back(0);
+                ++lossyOptions_;
+                if (loggedLossyTypes_.insert(sig).second)
+                    LOG_WARNING("Capture cannot encode option '", key, "' of type ", sig, "; it is dropped from the record");
+            }
+        }
+    }
+
+    file_.write(reinterpret_cast<const char*>(scratch_.data()), static_cast<std::streamsize>(scratch_.size()));
+    ++count_;
+
+    // Buffered by the stream rather than flushed per call
+    if (count_ % kFlushEveryRecords == 0 || now - lastFlush_ >= kFlushInterval) {
+        file_.flush();
+        lastFlush_ = now;
+    }
+}
+
+// ===========================================
+// CaptureReader Implementation
+// ===========================================
+CaptureReader::CaptureReader(const std::string& filename)
+    : file_(filename, std::ios::binary)
+{
+    char magic[sizeof(kMagic)] = {};
+    if (!file_.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), std::begin(kMagic)))
+        return;
+    if (file_.get() != kVersion)
+        return;
+
+    targetPaths_.resize(static_cast<std::size_t>(CallTarget::Count));
+    for (auto& path : targetPaths_) {
+        if (!getString(file_, path))
+            return;
+    }
+    ok_ = true;
+}
+
+bool CaptureReader::next(CapturedCall& call)
+{
+    if (!ok_)
+        return false;
+
+    std::uint64_t delta = 0;
+    if (!getVarint(file_, delta))
+        return false;
+    elapsed_ += std::chrono::microseconds(delta);
+    call.timestamp = elapsed_;
+
+    int target = file_.get();
+    int method = file_.get();
+    if (target < 0 || target >= static_cast<int>(CallTarget::Count) ||
+        method < 0 || method >= static_cast<int>(CallMethod::Count))
+        return false;
+    call.target = static_cast<CallTarget>(target);
+    call.method = static_cast<CallMethod>(method);
+
+    if (!getBytes(file_, call.payload) || !getString(file_, call.objectPath) || !getString(file_, call.property))
+        return false;
+
+    std::uint64_t count = 0;
+    if (!getVarint(file_, count))
+        return false;
+    call.options.clear();
+    call.lossy = false;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        CapturedOption o{};
+        int present = 0;
+        if (!getString(file_, o.key) || !getString(file_, o.signature) || (present = file_.get()) < 0)
+            return false;
+        o.lossy = present == 0;
+        if (!o.lossy && !decodeVariant(file_, o.signature, o.value, 0))
+            return false;
+        call.lossy = call.lossy || o.lossy;
+        call.options.push_back(std::move(o));
+    }
+    return true;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <sdbus-c++/sdbus-c++.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Record-and-replay of incoming method calls on the exported objects.
+//
+// File layout: "GCAP" magic, version byte, the object path of every
+// CallTarget (varint length + bytes), then one record per call:
+//   varint   microseconds since the previous record
+//   u8       CallTarget
+//   u8       CallMethod
+//   bytes    payload (WriteValue value / SelectConfiguration capabilities)
+//   string   object path argument (transport), empty if none
+//   string   property name of a Properties.Get, empty otherwise
+//   varint   option count, then per option:
+//              string  key
+//              string  full D-Bus signature of the value
+//              u8      1 if the value follows, 0 if its type cannot be captured
+//              value   encoded as below
+// Strings and byte arrays are varint length + bytes. Values: integers and
+// bools are varints (signed ones zigzag encoded), doubles 8 bytes little
+// endian, strings/object paths/signatures strings, arrays of those a varint
+// count followed by the elements, and a{sv} a varint count followed by key,
+// signature and value of every entry. Other types (structs, nested variants,
+// unix fds, arrays of bools or containers) are recorded as lossy.
+
+enum class CallTarget : std::uint8_t
+{
+    Service = 0,
+    Characteristic,
+    Advertisement,
+    Endpoint,
+    StreamCharacteristic,
+    Count
+};
+
+enum class CallMethod : std::uint8_t
+{
+    ReadValue = 0,
+    WriteValue,
+    StartNotify,
+    StopNotify,
+    Release,
+    SetConfiguration,
+    SelectConfiguration,
+    ClearConfiguration,
+    PropertiesGet,    // org.freedesktop.DBus.Properties.Get on the target's interface
+    PropertiesGetAll, // org.freedesktop.DBus.Properties.GetAll on the target's interface
+    Count
+};
+
+// Interface exported by the target object
+const char* interfaceNameOf(CallTarget target);
+// Interface the call is made on: the target's own, or Properties for property reads
+const char* interfaceNameOf(CallTarget target, CallMethod method);
+const char* methodNameOf(CallMethod method);
+
+struct CapturedOption
+{
+    std::string key;
+    std::string signature;
+    sdbus::Variant value; // empty if lossy
+    bool lossy;           // the value's type could not be captured
+};
+
+// Rebuilds the a{sv} options argument of a captured call. Lossy options are
+// missing from the result; check CapturedCall::lossy.
+std::map<std::string, sdbus::Variant> toOptions(const std::vector<CapturedOption>& options);
+
+struct CapturedCall
+{
+    std::chrono::microseconds timestamp; // since the start of the capture
+    CallTarget target;
+    CallMethod method;
+    std::vector<std::uint8_t> payload;
+    std::string objectPath;
+    std::string property;
+    std::vector<CapturedOption> options;
+    bool lossy; // at least one option could not be captured
+};
+
+class CallRecorder
+{
+public:
+    static CallRecorder& getInstance() {
+        static CallRecorder instance;
+        return instance;
+    }
+
+    // `targetPaths` holds the object path of each CallTarget, in enum order
+    bool open(const std::string& filename, const std::vector<std::string>& targetPaths);
+    void close();
+
+    bool enabled() const { return enabled_; }
+
+    void record(CallTarget target, CallMethod method,
+                const std::vector<std::uint8_t>& payload = {},
+                const std::map<std::string, sdbus::Variant>* options = nullptr,
+                const std::string& objectPath = {},
+                const std::string& property = {});
+
+private:
+    CallRecorder() = default;
+    ~CallRecorder() { close(); }
+
+    CallRecorder(const CallRecorder&) = delete;
+    CallRecorder& operator=(const CallRecorder&) = delete;
+
+    std::atomic<bool> enabled_{false};
+    std::ofstream file_;
+    std::vector<std::uint8_t> scratch_;
+    std::chrono::steady_clock::time_point last_{};
+    std::chrono::steady_clock::time_point lastFlush_{};
+    std::uint64_t count_{0};
+    std::uint64_t lossyOptions_{0};
+    std::set<std::string> loggedLossyTypes_;
+    std::mutex mutex_;
+};
+
+class CaptureReader
+{
+public:
+    explicit CaptureReader(const std::string& filename);
+
+    bool ok() const { return ok_; }
+    const std::string& targetPath(CallTarget target) const { return targetPaths_[static_cast<std::size_t>(target)]; }
+
+    // Reads the next call; returns false at the end of the file or on a malformed record
+    bool next(CapturedCall& call);
+
+private:
+    std::ifstream file_;
+    bool ok_{false};
+    std::vector<std::string> targetPaths_;
+    std::chrono::microseconds elapsed_{0};
+};
@@ -0,0 +1,41 @@
+#include "ClientMtu.h"
+#include "AllocStats.h"
+#include "Logger.h"
+
+namespace {
+constexpr const char* kOptionMtu = "mtu";
+} // namespace
+
+bool ClientMtu::update(const std::map<std::string, sdbus::Variant>& options)
+{
+    auto it = options.find(kOptionMtu);
+    if (it == options.end() || !it->second.containsValueOfType<uint16_t>())
+        return false;
+
+    std::size_t mtu = it->second.get<uint16_t>();
+    std::size_t current = smallest_.load();
+    while (current == 0 || mtu < current) {
+        if (smallest_.compare_exchange_weak(current, mtu))
+            return true;
+    }
+    return false;
+}
+
+std::size_t ClientMtu::value() const
+{
+    std::size_t mtu = smallest_.load();
+    return mtu ? mtu : kAttDefaultMtu;
+}
+
+void trackClientMtu(ClientMtu& mtu, const std::map<std::string, sdbus::Variant>& options)
+{
+    if (mtu.update(options))
+        LOG_DEBUG("[BLE] Packing notifications for MTU ", mtu.value());
+}
+
+void handleReadOptions(ClientMtu& mtu, const std::map<std::string, sdbus::Variant>& options)
+{
+    AllocScope scope("ReadValue", true);
+    trackClientMtu(mtu, options);
+    LOG_DEBUG("[BLE] ReadValue");
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <sdbus-c++/sdbus-c++.h>
+
+#include "MeasurementBatch.h"
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <string>
+
+// Smallest ATT MTU reported by any client since notifications were last idle.
+//
+// BlueZ passes the requesting client's MTU in the ReadValue/WriteValue
+// options, but StartNotify carries no options, so subscribers cannot be told
+// apart. Packing to the smallest MTU seen keeps every batch deliverable to
+// every subscriber; the limit only rises again after reset().
+class ClientMtu
+{
+public:
+    // Takes the "mtu" entry of ReadValue/WriteValue options, if present.
+    // Returns true if the effective MTU changed.
+    bool update(const std::map<std::string, sdbus::Variant>& options);
+
+    // Forget reported MTUs, e.g. once no client is subscribed anymore
+    void reset() { smallest_ = 0; }
+
+    // kAttDefaultMtu until a client reported one
+    std::size_t value() const;
+
+private:
+    std::atomic<std::size_t> smallest_{0};
+};
+
+// Takes the MTU from ReadValue/WriteValue options and logs when it changes
+void trackClientMtu(ClientMtu& mtu, const std::map<std::string, sdbus::Variant>& options);
+
+// Everything TemperatureCharacteristic::ReadValue does before copying the
+// reply, under its no-allocation AllocScope. Kept here so that AllocStatsTest
+// exercises the same code.
+void handleReadOptions(ClientMtu& mtu, const std::map<std::string, sdbus::Variant>& options);
@@ -1,4 +1,6 @@
 #include "GattServer.h"
+#include "AllocStats.h"
+#include "CallCapture.h"
 #include "Logger.h"
 
 #include <iostream>
@@ -8,10 +10,13 @@
 #include <thread>
 #include <fstream>
 #include <chrono>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 
 namespace {
 constexpr const char* kBluezService = "org.bluez";
+// Well-known name taken on a private bus, where the replay tool finds us
+constexpr const char* kPrivateBusName = "com.example.GattServer";
 
 constexpr const char* kIfaceProps = "org.freedesktop.DBus.Properties";
 constexpr const char* kIfaceObjMgr = "org.freedesktop.DBus.ObjectManager";
@@ -30,9 +35,42 @@ constexpr const char* kMethodUnregisterEndpoint = "UnregisterEndpoint";
 
 constexpr const char* kPropPowered = "Powered";
 
+constexpr long kShutdownTargetMs = 500;
+constexpr auto kLoopHeartbeatInterval = std::chrono::milliseconds(100);
+
+// Temperature values are sent as milli-degrees
+constexpr int8_t kTemperatureExponent = -3;
+
 constexpr const char* kUuidA2dpSink = "0000110B-0000-1000-8000-00805F9B34FB";
 constexpr uint8_t kCodecSbc = 0x00;
 
+// Set while we emit PropertiesChanged, whose getter calls are not client reads
+thread_local bool tEmittingProperties = false;
+
+struct EmittingPropertiesScope
+{
+    EmittingPropertiesScope() { tEmittingProperties = true; }
+    ~EmittingPropertiesScope() { tEmittingProperties = false; }
+};
+
+// Records a client Properties.Get/GetAll that reached a getter. GetAll runs
+// every getter of the interface, so only the `anchor` getter records it.
+// Reads made through ObjectManager.GetManagedObjects are not recorded.
+void recordPropertyRead(sdbus::IObject& object, CallTarget target, const char* property, bool anchor)
+{
+    auto& recorder = CallRecorder::getInstance();
+    if (!recorder.enabled() || tEmittingProperties)
+        return;
+
+    const char* member = object.getCurrentlyProcessedMessage().getMemberName();
+    if (member == nullptr)
+        return;
+    if (std::strcmp(member, "Get") == 0)
+        recorder.record(target, CallMethod::PropertiesGet, {}, nullptr, {}, property);
+    else if (anchor && std::strcmp(member, "GetAll") == 0)
+        recorder.record(target, CallMethod::PropertiesGetAll);
+}
+
 } // namespace
 
 // ===========================================
@@ -49,12 +87,30 @@ TemperatureService::~TemperatureService()
     unregisterAdaptor();
 }
 
+std::string TemperatureService::UUID()
+{
+    recordPropertyRead(getObject(), CallTarget::Service, "UUID", true);
+    AllocScope scope("Service.UUID");
+    return uuid_;
+}
+
+bool TemperatureService::Primary()
+{
+    recordPropertyRead(getObject(), CallTarget::Service, "Primary", false);
+    AllocScope scope("Service.Primary");
+    return primary_;
+}
+
 // ===========================================
 // Temperature Characteristic Implementation
 // ===========================================
-TemperatureCharacteristic::TemperatureCharacteristic(sdbus::IConnection& connection, std::string objectPath, std::string uuid, std::string servicePath)
-    : AdaptorInterfaces(connection, sdbus::ObjectPath(std::move(objectPath))), uuid_(std::move(uuid)), servicePath_(std::move(servicePath))
+TemperatureCharacteristic::TemperatureCharacteristic(sdbus::IConnection& connection, std::string objectPath, std::string uuid, std::string servicePath,
+                                                     CallTarget captureTarget)
+    : AdaptorInterfaces(connection, sdbus::ObjectPath(std::move(objectPath))), uuid_(std::move(uuid)), servicePath_(std::move(servicePath)),
+      captureTarget_(captureTarget)
 {
+    // Sized for the largest ATT payload so that value updates reuse the buffer
+    value_.reserve(512);
     value_ = {0x00};
     registerAdaptor();
 }
@@ -64,63 +120,100 @@ TemperatureCharacteristic::~TemperatureCharacteristic()
     unregisterAdaptor();
 }
 
-std::vector<uint8_t> TemperatureCharacteristic::ReadValue(const std::map<std::string, sdbus::Variant>&)
+std::vector<uint8_t> TemperatureCharacteristic::ReadValue(const std::map<std::string, sdbus::Variant>& options)
 {
-    std::ostringstream oss;
-    oss << "[BLE] ReadValue";
-    LOG_DEBUG(oss.str());
+    CallRecorder::getInstance().record(captureTarget_, CallMethod::ReadValue, {}, &options);
+    handleReadOptions(mtu_, options);
+    // The reply copy is required by the adaptor signature
     return value_;
 }
 
-void TemperatureCharacteristic::WriteValue(const std::vector<uint8_t>& value, const std::map<std::string, sdbus::Variant>&)
+void TemperatureCharacteristic::WriteValue(const std::vector<uint8_t>& value, const std::map<std::string, sdbus::Variant>& options)
 {
-    std::ostringstream oss;
-    oss << "[BLE] WriteValue: " << value.size() << " bytes";
-    LOG_DEBUG(oss.str());
+    CallRecorder::getInstance().record(captureTarget_, CallMethod::WriteValue, value, &options);
+    AllocScope scope("WriteValue");
+    trackClientMtu(mtu_, options);
+    LOG_DEBUG("[BLE] WriteValue: ", value.size(), " bytes");
     value_ = value;
     
-    // Emit signal
-    // emitPropertiesChangedSignal is available via ObjectHolder -> IObject
-    getObject().emitPropertiesChangedSignal(sdbus::InterfaceName(org::bluez::GattCharacteristic1_adaptor::INTERFACE_NAME), {sdbus::PropertyName("Value")});
+    emitPropertyChanged(valueProperty_);
 }
 
 void TemperatureCharacteristic::StartNotify()
 {
+    CallRecorder::getInstance().record(captureTarget_, CallMethod::StartNotify);
+    AllocScope scope("StartNotify");
     LOG_INFO("[BLE] StartNotify");
     notifying_ = true;
-    getObject().emitPropertiesChangedSignal(sdbus::InterfaceName(org::bluez::GattCharacteristic1_adaptor::INTERFACE_NAME), {sdbus::PropertyName("Notifying")});
+    emitPropertyChanged(notifyingProperty_);
 }
 
 void TemperatureCharacteristic::StopNotify()
 {
+    CallRecorder::getInstance().record(captureTarget_, CallMethod::StopNotify);
+    AllocScope scope("StopNotify");
     LOG_INFO("[BLE] StopNotify");
     notifying_ = false;
-    getObject().emitPropertiesChangedSignal(sdbus::InterfaceName(org::bluez::GattCharacteristic1_adaptor::INTERFACE_NAME), {sdbus::PropertyName("Notifying")});
+    mtu_.reset();
+    emitPropertyChanged(notifyingProperty_);
+}
+
+std::string TemperatureCharacteristic::UUID()
+{
+    recordPropertyRead(getObject(), captureTarget_, "UUID", true);
+    AllocScope scope("Characteristic.UUID");
+    return uuid_;
+}
+
+sdbus::ObjectPath TemperatureCharacteristic::Service()
+{
+    recordPropertyRead(getObject(), captureTarget_, "Service", false);
+    AllocScope scope("Characteristic.Service");
+    return servicePath_;
 }
 
 std::vector<uint8_t> TemperatureCharacteristic::Value()
 {
+    recordPropertyRead(getObject(), captureTarget_, "Value", false);
+    AllocScope scope("Characteristic.Value");
     return value_;
 }
 
 std::vector<std::string> TemperatureCharacteristic::Flags()
 {
-    return {"read", "write", "notify"};
+    recordPropertyRead(getObject(), captureTarget_, "Flags", false);
+    AllocScope scope("Characteristic.Flags");
+    return flags_;
+}
+
+bool TemperatureCharacteristic::Notifying()
+{
+    recordPropertyRead(getObject(), captureTarget_, "Notifying", false);
+    AllocScope scope("Characteristic.Notifying");
+    return notifying_;
 }
 
 void TemperatureCharacteristic::updateValue(const std::vector<uint8_t>& newValue)
 {
+    AllocScope scope("updateValue");
     value_ = newValue;
     if (notifying_) {
-        getObject().emitPropertiesChangedSignal(sdbus::InterfaceName(org::bluez::GattCharacteristic1_adaptor::INTERFACE_NAME), {sdbus::PropertyName("Value")});
+        emitPropertyChanged(valueProperty_);
     }
 }
 
+void TemperatureCharacteristic::emitPropertyChanged(const std::vector<sdbus::PropertyName>& properties)
+{
+    // emitPropertiesChangedSignal is available via ObjectHolder -> IObject
+    EmittingPropertiesScope emitting;
+    getObject().emitPropertiesChangedSignal(interfaceName_, properties);
+}
+
 // ===========================================
 // Advertisement Implementation
 // ===========================================
 OurAdvertisement::OurAdvertisement(sdbus::IConnection& connection, std::string objectPath, std::string type, std::string localName, std::string serviceUuid)
-    : AdaptorInterfaces(connection, sdbus::ObjectPath(std::move(objectPath))), type_(std::move(type)), localName_(std::move(localName)), serviceUuid_(std::move(serviceUuid))
+    : AdaptorInterfaces(connection, sdbus::ObjectPath(std::move(objectPath))), type_(std::move(type)), localName_(std::move(localName)), serviceUuids_{std::move(serviceUuid)}
 {
     registerAdaptor();
 }
@@ -130,8 +223,31 @@ OurAdvertisement::~OurAdvertisement()
     unregisterAdaptor();
 }
 
+std::string OurAdvertisement::Type()
+{
+    recordPropertyRead(getObject(), CallTarget::Advertisement, "Type", true);
+    AllocScope scope("Advertisement.Type");
+    return type_;
+}
+
+std::vector<std::string> OurAdvertisement::ServiceUUIDs()
+{
+    recordPropertyRead(getObject(), CallTarget::Advertisement, "ServiceUUIDs", false);
+    AllocScope scope("Advertisement.ServiceUUIDs");
+    return serviceUuids_;
+}
+
+std::string OurAdvertisement::LocalName()
+{
+    recordPropertyRead(getObject(), CallTarget::Advertisement, "LocalName", false);
+    AllocScope scope("Advertisement.LocalName");
+    return localName_;
+}
+
 void OurAdvertisement::Release()
 {
+    CallRecorder::getInstance().record(CallTarget::Advertisement, CallMethod::Release);
+    AllocScope scope("Advertisement.Release");
     LOG_INFO("Advertisement released");
 }
 
@@ -151,23 +267,31 @@ A2dpEndpoint::~A2dpEndpoint()
 
 void A2dpEndpoint::SetConfiguration(const sdbus::ObjectPath& transport, const std::map<std::string, sdbus::Variant>& properties)
 {
+    CallRecorder::getInstance().record(CallTarget::Endpoint, CallMethod::SetConfiguration, {}, &properties, transport);
+    AllocScope scope("MediaEndpoint.SetConfiguration");
     LOG_INFO("MediaEndpoint: SetConfiguration called via Adaptor");
     LOG_INFO("  Transport: ", transport);
 }
 
 std::vector<uint8_t> A2dpEndpoint::SelectConfiguration(const std::vector<uint8_t>& capabilities)
 {
+    CallRecorder::getInstance().record(CallTarget::Endpoint, CallMethod::SelectConfiguration, capabilities);
+    AllocScope scope("MediaEndpoint.SelectConfiguration");
     LOG_INFO("MediaEndpoint: SelectConfiguration called via Adaptor");
     return capabilities;
 }
 
 void A2dpEndpoint::ClearConfiguration(const sdbus::ObjectPath& transport)
 {
+    CallRecorder::getInstance().record(CallTarget::Endpoint, CallMethod::ClearConfiguration, {}, nullptr, transport);
+    AllocScope scope("MediaEndpoint.ClearConfiguration");
     LOG_INFO("MediaEndpoint: ClearConfiguration called via Adaptor");
 }
 
 void A2dpEndpoint::Release()
 {
+    CallRecorder::getInstance().record(CallTarget::Endpoint, CallMethod::Release);
+    AllocScope scope("MediaEndpoint.Release");
     LOG_INFO("MediaEndpoint: Release called via Adaptor");
 }
 
@@ -201,10 +325,16 @@ void GattServer::start()
         return;
 
     try {
-        conn_ = sdbus::createSystemBusConnection();
-        LOG_DEBUG("System D-Bus connection established");
+        if (busAddress_.empty()) {
+            conn_ = sdbus::createSystemBusConnection();
+            LOG_DEBUG("System D-Bus connection established");
+        } else {
+            conn_ = sdbus::createSessionBusConnectionWithAddress(busAddress_);
+            conn_->requestName(sdbus::ServiceName{kPrivateBusName});
+            LOG_DEBUG("Private D-Bus connection established at ", busAddress_);
+        }
     } catch (const sdbus::Error& e) {
-        LOG_ERROR("Failed to connect to system D-Bus: [", e.getName(), "] ", e.getMessage());
+        LOG_ERROR("Failed to connect to D-Bus: [", e.getName(), "] ", e.getMessage());
         throw;
     }
 
@@ -214,7 +344,10 @@ void GattServer::start()
         
         LOG_INFO("Creating Service Adaptors...");
         serviceObj_ = std::make_unique<TemperatureService>(*conn_, servicePath_, serviceUuid_, true);
-        charObj_ = std::make_unique<TemperatureCharacteristic>(*conn_, charPath_, charUuid_, servicePath_);
+        charObj_ = std::make_unique<TemperatureCharacteristic>(*conn_, charPath_, charUuid_, servicePath_, CallTarget::Characteristic);
+        if (streaming_)
+            streamCharObj_ = std::make_unique<TemperatureCharacteristic>(*conn_, streamCharPath_, streamCharUuid_, servicePath_,
+                                                                         CallTarget::StreamCharacteristic);
         advObj_ = std::make_unique<OurAdvertisement>(*conn_, advPath_, "peripheral", localName_, serviceUuid_);
         endpointObj_ = std::make_unique<A2dpEndpoint>(*conn_, endpointPath_);
         
@@ -224,7 +357,20 @@ void GattServer::start()
         throw;
     }
 
+    if (!captureFile_.empty())
+        CallRecorder::getInstance().open(captureFile_, {servicePath_, charPath_, advPath_, endpointPath_,
+                                                         streaming_ ? std::string(streamCharPath_) : std::string()});
+
     conn_->enterEventLoopAsync();
+
+    if (!busAddress_.empty()) {
+        // A private bus (e.g. for replaying captures) has no BlueZ to register with
+        LOG_INFO("Serving as ", kPrivateBusName, " without BlueZ registration");
+        startTemperatureThread();
+        startLoopMonitor();
+        return;
+    }
+
     adapterProxy_ = sdbus::createProxy(*conn_, sdbus::ServiceName{kBluezService}, adapterPath_);
     ensureAdapterPoweredOn();
     conn_->enterEventLoopAsync();
@@ -293,6 +439,14 @@ void GattServer::start()
     if (!err.empty()) throw std::runtime_error(err);
 
     startTemperatureThread();
+    startLoopMonitor();
+}
+
+void GattServer::startLoopMonitor()
+{
+    loopMonitor_ = std::make_unique<LoopMonitor>(*conn_, kLoopHeartbeatInterval, loopLagThreshold_);
+    loopMonitor_->start();
+    loopMonitor_->notifier().ready();
 }
 
 void GattServer::stop()
@@ -300,21 +454,81 @@ void GattServer::stop()
     if (!started_.exchange(false))
         return;
 
-    try { unregisterFromBlueZ(); } catch (...) {}
+    using Clock = std::chrono::steady_clock;
+    const auto begin = Clock::now();
+    const auto deadline = begin + shutdownDeadline_;
+    auto phaseStart = begin;
+    auto lap = [&phaseStart]() {
+        auto now = Clock::now();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - phaseStart).count();
+        phaseStart = now;
+        return ms;
+    };
+
+    // Stops watchdog pings as well; systemd is told we are going down
+    if (loopMonitor_) {
+        loopMonitor_->notifier().stopping();
+        loopMonitor_->stop();
+    }
+    auto monitorMs = lap();
+
+    // Wakes the sampler out of its wait, so this does not depend on the sample interval
+    try { stopTemperatureThread(); } catch (...) {}
+    auto samplerMs = lap();
+
+    // Needs the event loop running to receive the replies
+    try { unregisterFromBlueZ(deadline); } catch (...) {}
+    auto unregisterMs = lap();
+
     if (conn_) {
         try { conn_->leaveEventLoop(); } catch (...) {}
     }
-    try { stopTemperatureThread(); } catch (...) {}
+    // Only now that the loop thread is gone can no heartbeat reply reach the monitor
+    loopMonitor_.reset();
+    CallRecorder::getInstance().close();
+    auto eventLoopMs = lap();
 
-    // Destructors of adaptors handle unregisterAdaptor()
-    endpointObj_.reset();
+    // Destructors of adaptors handle unregisterAdaptor(). Tear down dependents
+    // first: the advertisement and characteristic reference the service.
     advObj_.reset();
+    endpointObj_.reset();
+    streamCharObj_.reset();
     charObj_.reset();
     serviceObj_.reset();
-    
     appObj_.reset();
+    auto adaptorsMs = lap();
+
     adapterProxy_.reset();
     conn_.reset();
+    auto connectionMs = lap();
+
+    auto totalMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - begin).count();
+    LOG_INFO("Shutdown took ", totalMs, "ms (monitor ", monitorMs, "ms, sampler ", samplerMs, "ms, unregister ", unregisterMs,
+             "ms, event loop ", eventLoopMs, "ms, adaptors ", adaptorsMs, "ms, connection ", connectionMs, "ms)");
+    if (totalMs > kShutdownTargetMs)
+        LOG_WARNING("Shutdown exceeded the ", kShutdownTargetMs, "ms target");
+
+    reportAllocationStats();
+}
+
+void GattServer::setShutdownDeadline(std::chrono::milliseconds deadline)
+{
+    shutdownDeadline_ = deadline;
+}
+
+void GattServer::setLoopLagThreshold(std::chrono::milliseconds threshold)
+{
+    loopLagThreshold_ = threshold;
+}
+
+void GattServer::setCaptureFile(std::string filename)
+{
+    captureFile_ = std::move(filename);
+}
+
+void GattServer::setBusAddress(std::string address)
+{
+    busAddress_ = std::move(address);
 }
 
 int GattServer::readCpuTemperatureMilliC()
@@ -334,44 +548,98 @@ int GattServer::readCpuTemperatureMilliC()
     return milli;
 }
 
+void GattServer::setMeasurementStreaming(bool enabled, std::chrono::milliseconds sampleInterval, std::chrono::milliseconds maxLatency)
+{
+    streaming_ = enabled;
+    if (enabled) {
+        sampleInterval_ = sampleInterval;
+        streamLatency_ = maxLatency;
+    }
+}
+
 void GattServer::startTemperatureThread()
 {
     if (tempThreadRunning_.exchange(true))
         return;
 
     tempThread_ = std::thread([this]() {
-        int lastMilli = -1;
-        while (tempThreadRunning_.load()) {
-            int milli = readCpuTemperatureMilliC();
-            if (milli != -1 && milli != lastMilli) {
-                lastMilli = milli;
+        if (streaming_)
+            runStreamingSampler();
+        else
+            runSingleValueSampler();
+    });
+}
 
-                // Simple IEEE-11073 conversion
-                uint8_t flags = 0x00;
-                int32_t mantissa = static_cast<int32_t>(milli);
-                int8_t exponent = -3;
-
-                std::vector<std::uint8_t> data(5);
-                data[0] = flags;
-                uint32_t mant = static_cast<uint32_t>(mantissa & 0xFFFFFF);
-                data[1] = static_cast<std::uint8_t>(mant & 0xFF);
-                data[2] = static_cast<std::uint8_t>((mant >> 8) & 0xFF);
-                data[3] = static_cast<std::uint8_t>((mant >> 16) & 0xFF);
-                data[4] = static_cast<std::uint8_t>(static_cast<uint8_t>(exponent));
-
-                // Update via Adaptor Access
-                if (charObj_) {
-                    charObj_->updateValue(data);
-                }
+void GattServer::runSingleValueSampler()
+{
+    int lastMilli = -1;
+    std::vector<std::uint8_t> data;
+    while (tempThreadRunning_.load()) {
+        int milli = readCpuTemperatureMilliC();
+        if (milli != -1 && milli != lastMilli) {
+            lastMilli = milli;
+            encodeMeasurementValue(milli, kTemperatureExponent, data);
+
+            // Update via Adaptor Access
+            if (charObj_) {
+                charObj_->updateValue(data);
             }
-            std::this_thread::sleep_for(std::chrono::seconds(2));
         }
-    });
+        waitForNextSample();
+    }
+}
+
+void GattServer::runStreamingSampler()
+{
+    LOG_INFO("Measurement streaming: sample every ", sampleInterval_.count(), "ms, flush within ", streamLatency_.count(), "ms");
+
+    const auto epoch = std::chrono::steady_clock::now();
+    MeasurementBatcher batcher(kAttDefaultMtu, streamLatency_, kTemperatureExponent);
+    std::vector<std::uint8_t> data;
+    std::vector<std::uint8_t> single;
+    int lastMilli = -1;
+
+    while (tempThreadRunning_.load()) {
+        auto now = std::chrono::steady_clock::now();
+        // Re-split a pending batch if a client with a smaller MTU showed up
+        while (streamCharObj_ && batcher.changeMtu(streamCharObj_->mtu(), data))
+            streamCharObj_->updateValue(data);
+
+        int milli = readCpuTemperatureMilliC();
+        if (milli != -1) {
+            // The Temperature Measurement characteristic keeps the standard format
+            if (milli != lastMilli && charObj_) {
+                lastMilli = milli;
+                encodeMeasurementValue(milli, kTemperatureExponent, single);
+                charObj_->updateValue(single);
+            }
+            auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(now - epoch).count();
+            if (batcher.add({static_cast<uint32_t>(ts), milli}, now, data) && streamCharObj_)
+                streamCharObj_->updateValue(data);
+        }
+        if (batcher.poll(now, data) && streamCharObj_)
+            streamCharObj_->updateValue(data);
+
+        waitForNextSample();
+    }
+
+    if (batcher.flush(data) && streamCharObj_)
+        streamCharObj_->updateValue(data);
+}
+
+void GattServer::waitForNextSample()
+{
+    std::unique_lock<std::mutex> lk(tempMutex_);
+    tempCv_.wait_for(lk, sampleInterval_, [this] { return !tempThreadRunning_.load(); });
 }
 
 void GattServer::stopTemperatureThread()
 {
-    tempThreadRunning_.store(false);
+    {
+        std::lock_guard<std::mutex> lk(tempMutex_);
+        tempThreadRunning_.store(false);
+    }
+    tempCv_.notify_all();
     if (tempThread_.joinable())
         tempThread_.join();
 }
@@ -394,14 +662,58 @@ void GattServer::ensureAdapterPoweredOn()
     } catch (...) {}
 }
 
-void GattServer::unregisterFromBlueZ()
+void GattServer::unregisterFromBlueZ(std::chrono::steady_clock::time_point deadline)
 {
     if (!adapterProxy_) return;
-    try {
-        adapterProxy_->callMethod(kMethodUnregisterEndpoint).onInterface(kIfaceMedia).withArguments(endpointPath_).storeResultsTo();
-        adapterProxy_->callMethod(kMethodUnregisterAdv).onInterface(kIfaceAdvMgr).withArguments(advPath_).storeResultsTo();
-        adapterProxy_->callMethod(kMethodUnregisterApp).onInterface(kIfaceGattMgr).withArguments(appPath_).storeResultsTo();
-    } catch (...) {}
+
+    // Shared with the reply handlers, which may outlive this call if BlueZ is slow
+    struct Pending
+    {
+        std::mutex m;
+        std::condition_variable cv;
+        int remaining{0};
+    };
+    auto pending = std::make_shared<Pending>();
+    auto timeout = std::max(std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()),
+                            std::chrono::microseconds(1));
+    std::vector<sdbus::PendingAsyncCall> calls;
+
+    auto unregister = [&](const char* method, const char* iface, const sdbus::ObjectPath& path) {
+        {
+            std::lock_guard<std::mutex> lk(pending->m);
+            ++pending->remaining;
+        }
+        try {
+            calls.push_back(adapterProxy_->callMethodAsync(method)
+                .onInterface(iface)
+                .withArguments(path)
+                .withTimeout(timeout)
+                .uponReplyInvoke([pending, method](std::optional<sdbus::Error> e) {
+                    if (e)
+                        LOG_WARNING(method, " failed: [", e->getName(), "] ", e->getMessage());
+                    std::lock_guard<std::mutex> lk(pending->m);
+                    --pending->remaining;
+                    pending->cv.notify_all();
+                }));
+        } catch (const sdbus::Error& e) {
+            LOG_WARNING(method, " failed: [", e.getName(), "] ", e.getMessage());
+            std::lock_guard<std::mutex> lk(pending->m);
+            --pending->remaining;
+        }
+    };
+
+    // Issued together so that a hung BlueZ costs one deadline, not three D-Bus timeouts
+    unregister(kMethodUnregisterEndpoint, kIfaceMedia, endpointPath_);
+    unregister(kMethodUnregisterAdv, kIfaceAdvMgr, advPath_);
+    unregister(kMethodUnregisterApp, kIfaceGattMgr, appPath_);
+
+    std::unique_lock<std::mutex> lk(pending->m);
+    if (!pending->cv.wait_until(lk, deadline, [&] { return pending->remaining == 0; })) {
+        LOG_WARNING("BlueZ did not answer ", pending->remaining, " unregister call(s) before the shutdown deadline");
+        lk.unlock();
+        for (auto& call : calls)
+            call.cancel();
+    }
 }
 
 void GattServer::notifyValueChanged()
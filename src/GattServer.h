@@ -5,11 +5,18 @@
 #include "GattCharacteristic1_adaptor.h"
 #include "LEAdvertisement1_adaptor.h"
 #include "MediaEndpoint1_adaptor.h"
+#include "CallCapture.h"
+#include "ClientMtu.h"
+#include "LoopMonitor.h"
+#include "MeasurementBatch.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <string>
 #include <vector>
@@ -21,8 +28,8 @@ public:
     TemperatureService(sdbus::IConnection& connection, std::string objectPath, std::string uuid, bool primary);
     ~TemperatureService();
 
-    std::string UUID() override { return uuid_; }
-    bool Primary() override { return primary_; }
+    std::string UUID() override;
+    bool Primary() override;
 
 private:
     std::string uuid_;
@@ -32,7 +39,9 @@ private:
 class TemperatureCharacteristic : public sdbus::AdaptorInterfaces<org::bluez::GattCharacteristic1_adaptor>
 {
 public:
-    TemperatureCharacteristic(sdbus::IConnection& connection, std::string objectPath, std::string uuid, std::string servicePath);
+    // `captureTarget` identifies this characteristic's calls in a capture (see CallCapture.h)
+    TemperatureCharacteristic(sdbus::IConnection& connection, std::string objectPath, std::string uuid, std::string servicePath,
+                              CallTarget captureTarget);
     ~TemperatureCharacteristic();
 
     // Adaptor overrides
@@ -41,19 +50,35 @@ public:
     void StartNotify() override;
     void StopNotify() override;
 
-    std::string UUID() override { return uuid_; }
-    sdbus::ObjectPath Service() override { return sdbus::ObjectPath(servicePath_); }
+    // Property getters return by value as the generated adaptor requires,
+    // so each Get copies the cached value
+    std::string UUID() override;
+    sdbus::ObjectPath Service() override;
     std::vector<uint8_t> Value() override;
     std::vector<std::string> Flags() override;
-    bool Notifying() override { return notifying_; }
+    bool Notifying() override;
 
     void updateValue(const std::vector<uint8_t>& newValue);
 
+    // Smallest ATT MTU reported by the clients (see ClientMtu)
+    std::size_t mtu() const { return mtu_.value(); }
+
 private:
-    std::string uuid_;
-    std::string servicePath_;
+    void emitPropertyChanged(const std::vector<sdbus::PropertyName>& properties);
+
+    // Immutable property values and signal arguments, built once per object
+    // rather than per Get/emit
+    const std::string uuid_;
+    const sdbus::ObjectPath servicePath_;
+    const CallTarget captureTarget_;
+    const std::vector<std::string> flags_{"read", "write", "notify"};
+    const sdbus::InterfaceName interfaceName_{org::bluez::GattCharacteristic1_adaptor::INTERFACE_NAME};
+    const std::vector<sdbus::PropertyName> valueProperty_{sdbus::PropertyName("Value")};
+    const std::vector<sdbus::PropertyName> notifyingProperty_{sdbus::PropertyName("Notifying")};
+
     std::vector<uint8_t> value_;
     std::atomic<bool> notifying_{false};
+    ClientMtu mtu_;
 };
 
 class OurAdvertisement : public sdbus::AdaptorInterfaces<org::bluez::LEAdvertisement1_adaptor>
@@ -63,16 +88,16 @@ public:
     ~OurAdvertisement();
 
     void Release() override;
-    std::string Type() override { return type_; }
-    std::vector<std::string> ServiceUUIDs() override { return {serviceUuid_}; }
-    std::string LocalName() override { return localName_; }
+    std::string Type() override;
+    std::vector<std::string> ServiceUUIDs() override;
+    std::string LocalName() override;
     // bool Discoverable() was not in the XML, so it's not in the generated adaptor
     // bool Discoverable() override { return true; }
 
 private:
-    std::string type_;
-    std::string localName_;
-    std::string serviceUuid_;
+    const std::string type_;
+    const std::string localName_;
+    const std::vector<std::string> serviceUuids_;
 };
 
 class A2dpEndpoint : public sdbus::AdaptorInterfaces<org::bluez::MediaEndpoint1_adaptor>
@@ -96,13 +121,35 @@ public:
     void start();
     void stop();
 
+    // Streaming mode: sample every `sampleInterval` and pack the samples into
+    // MTU-sized batch notifications, flushed at the latest after `maxLatency`.
+    // Batches go out on a separate vendor characteristic; the Temperature
+    // Measurement characteristic keeps the standard single-value format.
+    // Must be called before start().
+    void setMeasurementStreaming(bool enabled,
+                                 std::chrono::milliseconds sampleInterval = std::chrono::milliseconds(100),
+                                 std::chrono::milliseconds maxLatency = std::chrono::milliseconds(1000));
+
+    // Upper bound for waiting on BlueZ to acknowledge the unregister calls in stop()
+    void setShutdownDeadline(std::chrono::milliseconds deadline);
+
+    // Event-loop lag above which a stall is logged together with the loop's stack
+    void setLoopLagThreshold(std::chrono::milliseconds threshold);
+
+    // Records every incoming method call on the exported objects (see CallCapture.h)
+    void setCaptureFile(std::string filename);
+
+    // Serve on the bus at `address` instead of the system bus, without registering
+    // with BlueZ. Used to replay captures against a private dbus-daemon.
+    void setBusAddress(std::string address);
+
 private:
     using DictSV = std::map<std::string, sdbus::Variant>;
 
     void exportApplicationObjectManager();
 
     void ensureAdapterPoweredOn();
-    void unregisterFromBlueZ();
+    void unregisterFromBlueZ(std::chrono::steady_clock::time_point deadline);
     void notifyValueChanged();
 
     std::unique_ptr<sdbus::IConnection> conn_;
@@ -113,16 +160,35 @@ private:
     // Components
     std::unique_ptr<TemperatureService> serviceObj_;
     std::unique_ptr<TemperatureCharacteristic> charObj_;
+    std::unique_ptr<TemperatureCharacteristic> streamCharObj_; // only in streaming mode
     std::unique_ptr<OurAdvertisement> advObj_;
     std::unique_ptr<A2dpEndpoint> endpointObj_;
 
+    std::unique_ptr<LoopMonitor> loopMonitor_;
+    std::chrono::milliseconds loopLagThreshold_{200};
+
+    std::string captureFile_;
+    std::string busAddress_;
+
+    void startLoopMonitor();
+
     std::atomic<bool> started_{false};
+    std::chrono::milliseconds shutdownDeadline_{400};
 
     // Temperature sampling thread
     std::thread tempThread_;
     std::atomic<bool> tempThreadRunning_{false};
+    std::mutex tempMutex_;
+    std::condition_variable tempCv_;
+
+    bool streaming_{false};
+    std::chrono::milliseconds sampleInterval_{std::chrono::seconds(2)};
+    std::chrono::milliseconds streamLatency_{1000};
 
     int readCpuTemperatureMilliC();
+    void runSingleValueSampler();
+    void runStreamingSampler();
+    void waitForNextSample();
     void startTemperatureThread();
     void stopTemperatureThread();
 
@@ -130,11 +196,14 @@ private:
     const sdbus::ObjectPath appPath_{"/com/example/gatt/app"};
     const sdbus::ObjectPath servicePath_{"/com/example/gatt/app/service0"};
     const sdbus::ObjectPath charPath_{"/com/example/gatt/app/service0/char0"};
+    const sdbus::ObjectPath streamCharPath_{"/com/example/gatt/app/service0/char1"};
     const sdbus::ObjectPath advPath_{"/com/example/gatt/advertisement0"};
     const sdbus::ObjectPath endpointPath_{"/com/example/a2dp/endpoint0"};
 
     // Temperature Service config
     const std::string serviceUuid_{"00001809-0000-1000-8000-00805f9b34fb"};
     const std::string charUuid_{"00002A1C-0000-1000-8000-00805f9b34fb"};
+    // Vendor UUID for the batched stream (see MeasurementBatch.h)
+    const std::string streamCharUuid_{"6b3a1c2e-4f7d-4e1a-9c2b-8d5e0f1a2c3b"};
     const std::string localName_{"PiGattServer"};
 };
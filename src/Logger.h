@@ -2,12 +2,13 @@
 
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <mutex>
 #include <ctime>
 #include <iomanip>
 #include <memory>
+#include <memory_resource>
+#include <streambuf>
 
 enum class LogLevel {
     DEBUG = 0,
@@ -71,15 +72,44 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    std::string getCurrentTime() {
+    // Size of the per-thread arena used to format one log line
+    static constexpr std::size_t kScratchSize = 2048;
+
+    // One buffer per thread, shared by every log<Args...> instantiation
+    static char* scratchBuffer() {
+        thread_local char scratch[kScratchSize];
+        return scratch;
+    }
+
+    // Stream buffer appending to a (typically arena-backed) string
+    class StringSink : public std::streambuf {
+    public:
+        explicit StringSink(std::pmr::string& out) : out_(out) {}
+
+    protected:
+        int_type overflow(int_type ch) override {
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                out_.push_back(traits_type::to_char_type(ch));
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override {
+            out_.append(s, static_cast<std::size_t>(n));
+            return n;
+        }
+
+    private:
+        std::pmr::string& out_;
+    };
+
+    void writeCurrentTime(std::ostream& os) {
         auto now = std::time(nullptr);
-        auto tm = *std::localtime(&now);
-        std::ostringstream oss;
-        oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-        return oss.str();
+        std::tm tm{};
+        localtime_r(&now, &tm);
+        os << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
     }
 
-    std::string levelToString(LogLevel level) {
+    const char* levelToString(LogLevel level) {
         switch (level) {
             case LogLevel::DEBUG:   return "DEBUG";
             case LogLevel::INFO:    return "INFO";
@@ -95,21 +125,30 @@ private:
             return;
         }
 
-        std::ostringstream oss;
+        // Format into a thread-local arena so that logging from D-Bus handlers
+        // does not hit the heap unless a line outgrows the scratch buffer.
+        std::pmr::monotonic_buffer_resource arena(scratchBuffer(), kScratchSize);
+        std::pmr::string formattedMsg(&arena);
+        formattedMsg.reserve(kScratchSize / 2);
+
+        StringSink sink(formattedMsg);
+        std::ostream oss(&sink);
+        oss << "[";
+        writeCurrentTime(oss);
+        oss << "] [" << levelToString(level) << "] ";
         (oss << ... << std::forward<Args>(args));
-        
-        std::string message = oss.str();
-        std::string formattedMsg = "[" + getCurrentTime() + "] [" + levelToString(level) + "] " + message;
 
         std::lock_guard<std::mutex> lock(mutex_);
         
         if (logToConsole_) {
             std::ostream& out = (level >= LogLevel::ERROR) ? std::cerr : std::cout;
-            out << formattedMsg << std::endl;
+            out.write(formattedMsg.data(), static_cast<std::streamsize>(formattedMsg.size()));
+            out << std::endl;
         }
 
         if (logToFile_ && fileStream_.is_open()) {
-            fileStream_ << formattedMsg << std::endl;
+            fileStream_.write(formattedMsg.data(), static_cast<std::streamsize>(formattedMsg.size()));
+            fileStream_ << std::endl;
             fileStream_.flush();
         }
     }
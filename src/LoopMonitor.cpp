@@ -0,0 +1,223 @@
+#include "LoopMonitor.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+
+#include <execinfo.h>
+
+namespace {
+constexpr const char* kIfacePeer = "org.freedesktop.DBus.Peer";
+constexpr const char* kMethodPing = "Ping";
+
+// Signal used to make the event-loop thread record its own backtrace
+const int kStackSignal = SIGUSR2;
+constexpr int kMaxFrames = 64;
+constexpr auto kStackCaptureWait = std::chrono::milliseconds(100);
+
+// Ownership of gStackFrames: the monitor arms a capture, the handler only
+// writes the frames if it wins the Armed -> Writing transition, and the
+// monitor only reads them once they are Done. A signal that arrives after
+// the monitor gave up finds the capture Idle and leaves the frames alone.
+enum CaptureState : int
+{
+    kCaptureIdle,
+    kCaptureArmed,
+    kCaptureWriting,
+    kCaptureDone
+};
+
+void* gStackFrames[kMaxFrames];
+int gStackDepth = 0;
+std::atomic<int> gCaptureState{kCaptureIdle};
+
+void onStackSignal(int)
+{
+    int expected = kCaptureArmed;
+    if (!gCaptureState.compare_exchange_strong(expected, kCaptureWriting))
+        return;
+    gStackDepth = backtrace(gStackFrames, kMaxFrames);
+    gCaptureState.store(kCaptureDone);
+}
+} // namespace
+
+// ===========================================
+// LoopMonitor Implementation
+// ===========================================
+LoopMonitor::LoopMonitor(sdbus::IConnection& connection, std::chrono::milliseconds interval, std::chrono::milliseconds threshold)
+    : interval_(interval), threshold_(threshold)
+{
+    selfProxy_ = sdbus::createProxy(connection, sdbus::ServiceName(connection.getUniqueName()), sdbus::ObjectPath("/"));
+}
+
+LoopMonitor::~LoopMonitor()
+{
+    stop();
+}
+
+void LoopMonitor::start()
+{
+    if (running_.exchange(true))
+        return;
+
+    struct sigaction sa{};
+    sa.sa_handler = onStackSignal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(kStackSignal, &sa, nullptr);
+
+    // backtrace() loads libgcc lazily; do it now rather than inside the signal handler
+    void* warmup[1];
+    backtrace(warmup, 1);
+
+    lastBeat_ = Clock::now().time_since_epoch().count();
+    if (notifier_.watchdogInterval().count() > 0)
+        LOG_INFO("systemd watchdog enabled, interval ", notifier_.watchdogInterval().count(), "us");
+
+    thread_ = std::thread([this]() { run(); });
+}
+
+void LoopMonitor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (!running_.exchange(false))
+            return;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+    reportHistogram();
+}
+
+void LoopMonitor::run()
+{
+    WatchdogGate watchdog(notifier_, Clock::now());
+    // Wake often enough to send heartbeats, catch a stall as soon as it passes
+    // the threshold and keep up with the watchdog
+    Clock::duration wait = std::min<Clock::duration>(interval_, threshold_);
+    if (watchdog.enabled())
+        wait = std::min(wait, watchdog.period());
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (running_.load()) {
+        auto now = Clock::now();
+
+        if (!inFlight_.load()) {
+            sendHeartbeat(now);
+        } else if (!stallReported_.load() && now - sentAt_ > threshold_) {
+            stallReported_ = true;
+            lk.unlock();
+            captureLoopStack(std::chrono::duration_cast<std::chrono::milliseconds>(now - sentAt_));
+            lk.lock();
+        }
+
+        watchdog.poll(now, Clock::time_point(Clock::duration(lastBeat_.load())));
+
+        cv_.wait_for(lk, wait, [this] { return !running_.load(); });
+    }
+}
+
+void LoopMonitor::sendHeartbeat(Clock::time_point now)
+{
+    sentAt_ = now;
+    stallReported_ = false;
+    inFlight_ = true;
+    try {
+        selfProxy_->callMethodAsync(kMethodPing)
+            .onInterface(kIfacePeer)
+            .uponReplyInvoke([this, now](std::optional<sdbus::Error> e) {
+                if (e)
+                    LOG_WARNING("Loop heartbeat failed: [", e->getName(), "] ", e->getMessage());
+                onHeartbeat(now);
+            });
+    } catch (const sdbus::Error& e) {
+        LOG_WARNING("Failed to send loop heartbeat: [", e.getName(), "] ", e.getMessage());
+        inFlight_ = false;
+    }
+}
+
+void LoopMonitor::onHeartbeat(Clock::time_point sentAt)
+{
+    // Runs on the event-loop thread
+    if (!loopThreadKnown_.load()) {
+        loopThread_ = pthread_self();
+        loopThreadKnown_ = true;
+    }
+
+    auto now = Clock::now();
+    auto lag = std::chrono::duration_cast<std::chrono::microseconds>(now - sentAt);
+    record(lag);
+    lastBeat_ = now.time_since_epoch().count();
+    inFlight_ = false;
+
+    if (lag > threshold_)
+        LOG_WARNING("Event loop lagged ", lag.count() / 1000, "ms (threshold ", threshold_.count(), "ms)");
+}
+
+void LoopMonitor::record(std::chrono::microseconds lag)
+{
+    std::size_t bucket = 0;
+    while (bucket < kBucketBoundsMs.size() && lag >= std::chrono::milliseconds(kBucketBoundsMs[bucket]))
+        ++bucket;
+    ++buckets_[bucket];
+
+    auto us = lag.count();
+    auto prev = maxLagUs_.load();
+    while (us > prev && !maxLagUs_.compare_exchange_weak(prev, us)) {
+    }
+}
+
+void LoopMonitor::captureLoopStack(std::chrono::milliseconds lag)
+{
+    // Signal and wait before logging anything: the loop may be stalled inside
+    // Logger::log holding its mutex, and a LOG_* here would block until the
+    // stall ends, capturing wherever the loop went next.
+    bool captured = false;
+    if (loopThreadKnown_.load()) {
+        gCaptureState.store(kCaptureArmed);
+        if (pthread_kill(loopThread_.load(), kStackSignal) == 0) {
+            auto deadline = Clock::now() + kStackCaptureWait;
+            while (gCaptureState.load() != kCaptureDone && Clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        int expected = kCaptureArmed;
+        if (!gCaptureState.compare_exchange_strong(expected, kCaptureIdle)) {
+            // The handler is writing or done; it finishes without blocking
+            while (gCaptureState.load() != kCaptureDone)
+                std::this_thread::yield();
+            captured = true;
+        }
+    }
+
+    LOG_WARNING("Event loop blocked for ", lag.count(), "ms, stack of the event-loop thread:");
+    if (!captured || gStackDepth <= 0) {
+        LOG_WARNING("  (no stack captured)");
+        gCaptureState.store(kCaptureIdle);
+        return;
+    }
+
+    char** symbols = backtrace_symbols(gStackFrames, gStackDepth);
+    // Skip the signal handler and the signal trampoline
+    for (int i = 2; i < gStackDepth; ++i)
+        LOG_WARNING("  #", i - 2, " ", symbols ? symbols[i] : "?");
+    std::free(symbols);
+    gCaptureState.store(kCaptureIdle);
+}
+
+void LoopMonitor::reportHistogram() const
+{
+    LOG_INFO("Event loop lag histogram (max ", maxLagUs_.load() / 1000.0, "ms):");
+    std::int64_t lower = 0;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        auto count = buckets_[i].load();
+        if (i < kBucketBoundsMs.size()) {
+            LOG_INFO("  [", lower, ", ", kBucketBoundsMs[i], ") ms: ", count);
+            lower = kBucketBoundsMs[i];
+        } else {
+            LOG_INFO("  >= ", lower, " ms: ", count);
+        }
+    }
+}
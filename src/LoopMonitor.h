@@ -0,0 +1,77 @@
+#pragma once
+
+#include <sdbus-c++/sdbus-c++.h>
+
+#include "SystemdNotifier.h"
+#include "WatchdogGate.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+
+// Measures how late the sdbus event loop runs.
+//
+// A monitor thread periodically pings our own connection through the bus
+// (org.freedesktop.DBus.Peer.Ping). Both the incoming ping and its reply are
+// dispatched by the event-loop thread, so the round trip grows with any
+// handler that blocks the loop. Round trips are kept in a histogram. When a
+// ping stays unanswered past the threshold, the loop thread's stack is
+// captured and logged.
+//
+// If systemd enabled the watchdog ($WATCHDOG_USEC), WATCHDOG=1 is only sent
+// while the loop keeps answering (see WatchdogGate), so a wedged loop gets the
+// service restarted.
+class LoopMonitor
+{
+public:
+    LoopMonitor(sdbus::IConnection& connection, std::chrono::milliseconds interval, std::chrono::milliseconds threshold);
+    ~LoopMonitor();
+
+    LoopMonitor(const LoopMonitor&) = delete;
+    LoopMonitor& operator=(const LoopMonitor&) = delete;
+
+    void start();
+    void stop();
+
+    void reportHistogram() const;
+
+    SystemdNotifier& notifier() { return notifier_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Upper bounds (ms) of the lag histogram buckets; the last bucket is open-ended
+    static constexpr std::array<std::int64_t, 10> kBucketBoundsMs{1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+    void run();
+    void sendHeartbeat(Clock::time_point now);
+    void onHeartbeat(Clock::time_point sentAt);
+    void record(std::chrono::microseconds lag);
+    void captureLoopStack(std::chrono::milliseconds lag);
+
+    std::unique_ptr<sdbus::IProxy> selfProxy_;
+    std::chrono::milliseconds interval_;
+    std::chrono::milliseconds threshold_;
+    SystemdNotifier notifier_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    std::atomic<bool> inFlight_{false};
+    std::atomic<bool> stallReported_{false};
+    Clock::time_point sentAt_{};
+    std::atomic<Clock::rep> lastBeat_{0};
+    std::atomic<pthread_t> loopThread_{};
+    std::atomic<bool> loopThreadKnown_{false};
+
+    std::array<std::atomic<std::uint64_t>, kBucketBoundsMs.size() + 1> buckets_{};
+    std::atomic<std::int64_t> maxLagUs_{0};
+};
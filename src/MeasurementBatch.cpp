@@ -0,0 +1,235 @@
+#include "MeasurementBatch.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+constexpr std::size_t kBatchHeaderSize = 10;
+constexpr std::size_t kMaxBatchSamples = 0xFF;
+// Reserved bits of the Temperature Measurement flags, excluding the batch marker
+constexpr std::uint8_t kMeasurementFlagsReserved = 0x78;
+
+std::size_t varintSize(std::uint64_t v)
+{
+    std::size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+bool getVarint(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        std::uint8_t b = *p++;
+        v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+std::uint64_t zigzag(std::int64_t v)
+{
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t v)
+{
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+void putU32(std::vector<std::uint8_t>& out, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFF));
+}
+
+std::uint32_t getU32(const std::uint8_t* p)
+{
+    return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+// IEEE-11073 32-bit FLOAT: 24-bit mantissa followed by the exponent
+void putFloat(std::vector<std::uint8_t>& out, std::int32_t mantissa, std::int8_t exponent)
+{
+    std::uint32_t mant = static_cast<std::uint32_t>(mantissa & 0xFFFFFF);
+    out.push_back(static_cast<std::uint8_t>(mant & 0xFF));
+    out.push_back(static_cast<std::uint8_t>((mant >> 8) & 0xFF));
+    out.push_back(static_cast<std::uint8_t>((mant >> 16) & 0xFF));
+    out.push_back(static_cast<std::uint8_t>(exponent));
+}
+
+std::int32_t getMantissa24(const std::uint8_t* p)
+{
+    std::uint32_t mant = static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+                         (static_cast<std::uint32_t>(p[2]) << 16);
+    if (mant & 0x800000)
+        mant |= 0xFF000000;
+    return static_cast<std::int32_t>(mant);
+}
+} // namespace
+
+void encodeMeasurementValue(std::int32_t mantissa, std::int8_t exponent, std::vector<std::uint8_t>& out)
+{
+    out.clear();
+    out.push_back(0x00);
+    putFloat(out, mantissa, exponent);
+}
+
+// ===========================================
+// MeasurementBatcher Implementation
+// ===========================================
+MeasurementBatcher::MeasurementBatcher(std::size_t mtu, std::chrono::milliseconds maxLatency, std::int8_t exponent)
+    : maxLatency_(maxLatency), exponent_(exponent)
+{
+    pending_.reserve(kMaxBatchSamples);
+    setMtu(mtu);
+}
+
+void MeasurementBatcher::setMtu(std::size_t mtu)
+{
+    payloadLimit_ = std::max(mtu, kAttDefaultMtu) - kAttNotifyHeader;
+    buf_.reserve(payloadLimit_);
+}
+
+bool MeasurementBatcher::changeMtu(std::size_t mtu, std::vector<std::uint8_t>& out)
+{
+    setMtu(mtu);
+    if (buf_.size() <= payloadLimit_)
+        return false;
+
+    std::size_t sent = encode(pending_.data(), pending_.size(), payloadLimit_, out);
+    pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(sent));
+
+    // The remainder may still exceed the limit; the next call splits it again
+    count_ = encode(pending_.data(), pending_.size(), SIZE_MAX, buf_);
+    return true;
+}
+
+std::size_t MeasurementBatcher::encode(const MeasurementSample* samples, std::size_t count, std::size_t limit, std::vector<std::uint8_t>& out) const
+{
+    out.clear();
+    out.push_back(kMeasurementFlagBatch);
+    out.push_back(1);
+    putU32(out, samples[0].timestampMs);
+    putFloat(out, samples[0].mantissa, exponent_);
+
+    std::size_t n = 1;
+    for (; n < count; ++n) {
+        std::uint32_t dt = samples[n].timestampMs - samples[n - 1].timestampMs;
+        std::uint64_t dv = zigzag(static_cast<std::int64_t>(samples[n].mantissa) - samples[n - 1].mantissa);
+        if (out.size() + varintSize(dt) + varintSize(dv) > limit)
+            break;
+        putVarint(out, dt);
+        putVarint(out, dv);
+    }
+    out[1] = static_cast<std::uint8_t>(n);
+    return n;
+}
+
+void MeasurementBatcher::start(const MeasurementSample& sample, std::chrono::steady_clock::time_point now)
+{
+    pending_.clear();
+    pending_.push_back(sample);
+    count_ = encode(&sample, 1, SIZE_MAX, buf_);
+    last_ = sample;
+    firstAt_ = now;
+}
+
+bool MeasurementBatcher::add(const MeasurementSample& sample, std::chrono::steady_clock::time_point now, std::vector<std::uint8_t>& out)
+{
+    if (count_ == 0) {
+        start(sample, now);
+        return false;
+    }
+
+    std::uint32_t dt = sample.timestampMs - last_.timestampMs;
+    std::uint64_t dv = zigzag(static_cast<std::int64_t>(sample.mantissa) - last_.mantissa);
+
+    if (count_ >= kMaxBatchSamples || buf_.size() + varintSize(dt) + varintSize(dv) > payloadLimit_) {
+        bool flushed = flush(out);
+        start(sample, now);
+        return flushed;
+    }
+
+    putVarint(buf_, dt);
+    putVarint(buf_, dv);
+    buf_[1] = static_cast<std::uint8_t>(++count_);
+    pending_.push_back(sample);
+    last_ = sample;
+    return false;
+}
+
+bool MeasurementBatcher::poll(std::chrono::steady_clock::time_point now, std::vector<std::uint8_t>& out)
+{
+    if (count_ == 0 || now < deadline())
+        return false;
+    return flush(out);
+}
+
+bool MeasurementBatcher::flush(std::vector<std::uint8_t>& out)
+{
+    if (count_ == 0)
+        return false;
+    out.assign(buf_.begin(), buf_.end());
+    buf_.clear();
+    pending_.clear();
+    count_ = 0;
+    return true;
+}
+
+// ===========================================
+// Decoder
+// ===========================================
+bool decodeMeasurementNotification(const std::uint8_t* data, std::size_t size, std::vector<MeasurementSample>& out, std::int8_t* exponent)
+{
+    out.clear();
+    if (size == 0)
+        return false;
+
+    if (!(data[0] & kMeasurementFlagBatch)) {
+        if (size < 5)
+            return false;
+        out.push_back({0, getMantissa24(data + 1)});
+        if (exponent)
+            *exponent = static_cast<std::int8_t>(data[4]);
+        return true;
+    }
+
+    if (size < kBatchHeaderSize || (data[0] & kMeasurementFlagsReserved))
+        return false;
+
+    std::size_t count = data[1];
+    if (count == 0)
+        return false;
+    MeasurementSample s{getU32(data + 2), getMantissa24(data + 6)};
+    if (exponent)
+        *exponent = static_cast<std::int8_t>(data[9]);
+    out.push_back(s);
+
+    const std::uint8_t* p = data + kBatchHeaderSize;
+    const std::uint8_t* end = data + size;
+    while (out.size() < count) {
+        std::uint64_t dt = 0;
+        std::uint64_t dv = 0;
+        if (!getVarint(p, end, dt) || !getVarint(p, end, dv))
+            return false;
+        s.timestampMs += static_cast<std::uint32_t>(dt);
+        s.mantissa = static_cast<std::int32_t>(s.mantissa + unzigzag(dv));
+        out.push_back(s);
+    }
+    return p == end;
+}
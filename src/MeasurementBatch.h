@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ATT notification header (opcode + handle) that precedes every value on the wire.
+constexpr std::size_t kAttNotifyHeader = 3;
+constexpr std::size_t kAttDefaultMtu = 23;
+
+// Flags bit marking a batched measurement notification. Batches are only sent
+// on the vendor streaming characteristic, never on Temperature Measurement
+// (0x2A1C), where standard clients would ignore the bit and misread the batch.
+// Bits 3-7 of the standard flags are reserved, so the bit still tells the two
+// formats apart in the decoder.
+constexpr std::uint8_t kMeasurementFlagBatch = 0x80;
+
+struct MeasurementSample
+{
+    std::uint32_t timestampMs;
+    std::int32_t mantissa;
+};
+
+// Writes a single IEEE-11073 32-bit FLOAT measurement (flags + 24-bit mantissa + exponent).
+void encodeMeasurementValue(std::int32_t mantissa, std::int8_t exponent, std::vector<std::uint8_t>& out);
+
+// Packs timestamped samples into one notification that fits the negotiated MTU.
+//
+// Layout (little endian):
+//   [0]    flags | kMeasurementFlagBatch
+//   [1]    sample count
+//   [2..5] timestamp of the first sample, ms
+//   [6..9] first sample as IEEE-11073 FLOAT (the exponent applies to the whole batch)
+//   then per further sample: varint(dt ms), zigzag varint(d mantissa)
+class MeasurementBatcher
+{
+public:
+    MeasurementBatcher(std::size_t mtu, std::chrono::milliseconds maxLatency, std::int8_t exponent = -3);
+
+    // Sets the MTU while no batch is pending
+    void setMtu(std::size_t mtu);
+    std::size_t payloadLimit() const { return payloadLimit_; }
+
+    // Changes the MTU of a running stream. If the pending batch no longer
+    // fits, the samples that do are moved to `out` and the rest stay pending;
+    // call again until it returns false.
+    bool changeMtu(std::size_t mtu, std::vector<std::uint8_t>& out);
+
+    // Adds a sample. Returns true and fills `out` when the pending batch had
+    // to be flushed to make room for it.
+    bool add(const MeasurementSample& sample, std::chrono::steady_clock::time_point now, std::vector<std::uint8_t>& out);
+
+    // Returns true and fills `out` once the oldest pending sample exceeds the latency deadline.
+    bool poll(std::chrono::steady_clock::time_point now, std::vector<std::uint8_t>& out);
+
+    // Returns true and fills `out` if any samples are pending.
+    bool flush(std::vector<std::uint8_t>& out);
+
+    bool empty() const { return count_ == 0; }
+    std::chrono::steady_clock::time_point deadline() const { return firstAt_ + maxLatency_; }
+
+private:
+    void start(const MeasurementSample& sample, std::chrono::steady_clock::time_point now);
+    // Encodes the longest prefix of `samples` that fits in `limit` bytes; returns its length
+    std::size_t encode(const MeasurementSample* samples, std::size_t count, std::size_t limit, std::vector<std::uint8_t>& out) const;
+
+    std::size_t payloadLimit_;
+    std::chrono::milliseconds maxLatency_;
+    std::int8_t exponent_;
+
+    std::vector<std::uint8_t> buf_;
+    std::vector<MeasurementSample> pending_;
+    std::size_t count_{0};
+    MeasurementSample last_{};
+    std::chrono::steady_clock::time_point firstAt_{};
+};
+
+// Decodes either a single-value or a batched measurement notification.
+// Single values carry no timestamp and decode with timestampMs = 0.
+// Returns false if the payload is malformed, including empty batches and
+// batches with reserved flag bits set.
+bool decodeMeasurementNotification(const std::uint8_t* data, std::size_t size, std::vector<MeasurementSample>& out, std::int8_t* exponent = nullptr);
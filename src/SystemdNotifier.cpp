@@ -0,0 +1,63 @@
+#include "SystemdNotifier.h"
+#include "Logger.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+SystemdNotifier::SystemdNotifier()
+{
+    const char* socketPath = std::getenv("NOTIFY_SOCKET");
+    if (!socketPath || !*socketPath)
+        return;
+
+    sockaddr_un addr{};
+    if (std::strlen(socketPath) >= sizeof(addr.sun_path)) {
+        LOG_WARNING("NOTIFY_SOCKET path too long, systemd notifications disabled");
+        return;
+    }
+
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        LOG_WARNING("Failed to create notify socket: ", std::strerror(errno));
+        return;
+    }
+    socketPath_ = socketPath;
+
+    // The watchdog only applies to the process it was meant for
+    const char* usec = std::getenv("WATCHDOG_USEC");
+    const char* pid = std::getenv("WATCHDOG_PID");
+    if (usec && (!pid || std::strtol(pid, nullptr, 10) == ::getpid()))
+        watchdogInterval_ = std::chrono::microseconds(std::strtoull(usec, nullptr, 10));
+}
+
+SystemdNotifier::~SystemdNotifier()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+bool SystemdNotifier::notify(const std::string& state)
+{
+    if (fd_ < 0)
+        return false;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socketPath_.data(), socketPath_.size());
+    // '@' denotes a socket in the abstract namespace
+    if (addr.sun_path[0] == '@')
+        addr.sun_path[0] = '\0';
+    auto len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + socketPath_.size());
+
+    if (::sendto(fd_, state.data(), state.size(), MSG_NOSIGNAL, reinterpret_cast<sockaddr*>(&addr), len) < 0) {
+        LOG_WARNING("sd_notify(", state, ") failed: ", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
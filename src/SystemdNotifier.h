@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// Minimal sd_notify(3) client: sends state datagrams to $NOTIFY_SOCKET.
+// All calls are no-ops when the process is not started by systemd.
+class SystemdNotifier
+{
+public:
+    SystemdNotifier();
+    ~SystemdNotifier();
+
+    SystemdNotifier(const SystemdNotifier&) = delete;
+    SystemdNotifier& operator=(const SystemdNotifier&) = delete;
+
+    bool enabled() const { return fd_ >= 0; }
+
+    // Interval requested via $WATCHDOG_USEC, zero if the watchdog is off
+    std::chrono::microseconds watchdogInterval() const { return watchdogInterval_; }
+
+    bool notify(const std::string& state);
+    bool ready() { return notify("READY=1"); }
+    bool stopping() { return notify("STOPPING=1"); }
+    bool watchdog() { return notify("WATCHDOG=1"); }
+
+private:
+    int fd_{-1};
+    std::string socketPath_;
+    std::chrono::microseconds watchdogInterval_{0};
+};
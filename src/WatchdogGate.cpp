@@ -0,0 +1,26 @@
+#include "WatchdogGate.h"
+#include "Logger.h"
+
+WatchdogGate::WatchdogGate(SystemdNotifier& notifier, Clock::time_point now)
+    : notifier_(notifier),
+      interval_(std::chrono::duration_cast<Clock::duration>(notifier.watchdogInterval())),
+      period_(interval_ / 2),
+      next_(now)
+{
+}
+
+bool WatchdogGate::poll(Clock::time_point now, Clock::time_point lastBeat)
+{
+    if (!enabled() || now < next_)
+        return true;
+    next_ = now + period_;
+
+    auto sinceBeat = now - lastBeat;
+    if (sinceBeat >= interval_) {
+        LOG_ERROR("Event loop unresponsive for ", std::chrono::duration_cast<std::chrono::milliseconds>(sinceBeat).count(),
+                  "ms, withholding watchdog ping");
+        return false;
+    }
+    notifier_.watchdog();
+    return true;
+}
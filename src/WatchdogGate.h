@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SystemdNotifier.h"
+
+#include <chrono>
+
+// Decides when LoopMonitor sends WATCHDOG=1: every half watchdog interval,
+// as systemd recommends, but only while the event loop answered a heartbeat
+// within the last full interval. A wedged loop therefore stops the pings and
+// systemd restarts the service.
+class WatchdogGate
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // The first ping is due at `now`
+    WatchdogGate(SystemdNotifier& notifier, Clock::time_point now);
+
+    // False if systemd did not enable the watchdog
+    bool enabled() const { return period_.count() > 0; }
+    Clock::duration period() const { return period_; }
+
+    // Sends WATCHDOG=1 if a ping is due and `lastBeat` is recent enough.
+    // Returns false if a due ping was withheld.
+    bool poll(Clock::time_point now, Clock::time_point lastBeat);
+
+private:
+    SystemdNotifier& notifier_;
+    Clock::duration interval_;
+    Clock::duration period_;
+    Clock::time_point next_;
+};
@@ -2,9 +2,13 @@
 #include "Logger.h"
 
 #include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <climits>
 #include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <thread>
 
 namespace {
@@ -14,10 +18,58 @@ void onSignal(int sig) {
     LOG_INFO("Received signal ", sig, ", stopping...");
     gStop = true;
 }
+
+void usage()
+{
+    std::cerr << "Usage: GattServer [--stream] [--shutdown-timeout-ms N] [--lag-threshold-ms N] [--capture FILE] [--bus ADDRESS]\n";
+}
+
+// Parses a strictly positive number of milliseconds; rejects trailing garbage
+bool parsePositiveMs(const char* text, std::chrono::milliseconds& out)
+{
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value <= 0 || value > INT_MAX)
+        return false;
+    out = std::chrono::milliseconds(value);
+    return true;
+}
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    bool streaming = false;
+    std::chrono::milliseconds shutdownTimeout{400};
+    std::chrono::milliseconds lagThreshold{200};
+    std::string captureFile;
+    std::string busAddress;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--stream") {
+            streaming = true;
+        } else if ((arg == "--shutdown-timeout-ms" || arg == "--lag-threshold-ms") && hasValue) {
+            auto& target = arg == "--shutdown-timeout-ms" ? shutdownTimeout : lagThreshold;
+            if (!parsePositiveMs(argv[++i], target)) {
+                std::cerr << arg << ": expected a positive number of milliseconds, got '" << argv[i] << "'\n";
+                return 2;
+            }
+        } else if (arg == "--capture" && hasValue) {
+            captureFile = argv[++i];
+        } else if (arg == "--bus" && hasValue) {
+            busAddress = argv[++i];
+        } else if (arg == "--shutdown-timeout-ms" || arg == "--lag-threshold-ms" || arg == "--capture" || arg == "--bus") {
+            std::cerr << "Missing value for " << arg << "\n";
+            usage();
+            return 2;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            usage();
+            return 2;
+        }
+    }
+
     // Initialize logger
     Logger::getInstance().setLogLevel(LogLevel::DEBUG);
     Logger::getInstance().setLogFile("/var/log/gatt_server.log");
@@ -31,6 +83,11 @@ int main()
     try
     {
         GattServer server;
+        server.setMeasurementStreaming(streaming);
+        server.setShutdownDeadline(shutdownTimeout);
+        server.setLoopLagThreshold(lagThreshold);
+        server.setCaptureFile(captureFile);
+        server.setBusAddress(busAddress);
         server.start();
 
         LOG_INFO("GATT Server running. Press Ctrl+C to stop.");
@@ -0,0 +1,54 @@
+// Asserts that the ReadValue path (handleReadOptions, which ReadValue calls
+// before copying the reply) makes no heap allocations in steady state.
+// Built with GATT_ALLOC_ACCOUNTING=1 so that the counting operator new is linked.
+#include "AllocStats.h"
+#include "ClientMtu.h"
+#include "Logger.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+
+#if !GATT_ALLOC_ACCOUNTING
+#error "AllocStatsTest must be built with GATT_ALLOC_ACCOUNTING=1"
+#endif
+
+namespace {
+constexpr int kReads = 1000;
+} // namespace
+
+int main()
+{
+    auto logFile = (std::filesystem::temp_directory_path() / "gatt_alloc_stats_test.log").string();
+    Logger::getInstance().setLogLevel(LogLevel::DEBUG);
+    Logger::getInstance().setLogFile(logFile);
+    Logger::getInstance().setLogToConsole(false);
+
+    // What BlueZ sends with a read from an LE client
+    std::map<std::string, sdbus::Variant> options;
+    options["device"] = sdbus::Variant(sdbus::ObjectPath("/org/bluez/hci0/dev_AA_BB_CC_DD_EE_FF"));
+    options["mtu"] = sdbus::Variant(static_cast<std::uint16_t>(185));
+    options["offset"] = sdbus::Variant(static_cast<std::uint16_t>(0));
+    options["link"] = sdbus::Variant(std::string("LE"));
+
+    ClientMtu mtu;
+    handleReadOptions(mtu, options);
+
+    int failures = 0;
+    for (int i = 0; i < kReads; ++i) {
+        AllocScope scope("AllocStatsTest", true);
+        handleReadOptions(mtu, options);
+        if (scope.allocations() != 0)
+            ++failures;
+    }
+
+    std::remove(logFile.c_str());
+    if (failures) {
+        std::cerr << "ReadValue path allocated in " << failures << " of " << kReads << " reads\n";
+        return 1;
+    }
+    return 0;
+}
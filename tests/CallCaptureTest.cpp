@@ -0,0 +1,115 @@
+// Round-trips calls through CallRecorder and CaptureReader, including the
+// option types BlueZ sends with SetConfiguration.
+#include "CallCapture.h"
+#include "Check.h"
+#include "Logger.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+using Dict = std::map<std::string, sdbus::Variant>;
+
+std::string capturePath()
+{
+    return (std::filesystem::temp_directory_path() / "gatt_call_capture_test.gcap").string();
+}
+
+const std::vector<std::string> kTargetPaths{"/service", "/char", "/adv", "/endpoint", "/stream"};
+
+void testOptionsRoundTrip()
+{
+    Dict qos{{"Interval", sdbus::Variant(std::uint32_t{10000})}, {"Framing", sdbus::Variant(true)}};
+    Dict properties{
+        {"Device", sdbus::Variant(sdbus::ObjectPath("/org/bluez/hci0/dev_AA_BB_CC_DD_EE_FF"))},
+        {"UUID", sdbus::Variant(std::string("0000110B-0000-1000-8000-00805F9B34FB"))},
+        {"Codec", sdbus::Variant(std::uint8_t{0})},
+        {"Configuration", sdbus::Variant(std::vector<std::uint8_t>{0x21, 0x15, 0x02, 0x35})},
+        {"Delay", sdbus::Variant(std::uint16_t{150})},
+        {"Offset", sdbus::Variant(std::int16_t{-3})},
+        {"Gain", sdbus::Variant(-1.5)},
+        {"Stamp", sdbus::Variant(std::int64_t{-5000000000LL})},
+        {"Links", sdbus::Variant(std::vector<sdbus::ObjectPath>{sdbus::ObjectPath("/a"), sdbus::ObjectPath("/b")})},
+        {"QoS", sdbus::Variant(qos)},
+    };
+
+    auto path = capturePath();
+    auto& recorder = CallRecorder::getInstance();
+    CHECK(recorder.open(path, kTargetPaths));
+    recorder.record(CallTarget::Endpoint, CallMethod::SetConfiguration, {}, &properties, "/org/bluez/hci0/dev_AA/fd0");
+    recorder.record(CallTarget::Service, CallMethod::PropertiesGet, {}, nullptr, {}, "UUID");
+    recorder.close();
+
+    CaptureReader reader(path);
+    CHECK(reader.ok());
+    CHECK(reader.targetPath(CallTarget::StreamCharacteristic) == "/stream");
+
+    CapturedCall call;
+    CHECK(reader.next(call));
+    CHECK(call.method == CallMethod::SetConfiguration);
+    CHECK(call.objectPath == "/org/bluez/hci0/dev_AA/fd0");
+    CHECK(!call.lossy);
+
+    auto replayed = toOptions(call.options);
+    CHECK(replayed.size() == properties.size());
+    CHECK(std::string(replayed["Configuration"].peekValueType()) == "ay");
+    CHECK((replayed["Configuration"].get<std::vector<std::uint8_t>>() == std::vector<std::uint8_t>{0x21, 0x15, 0x02, 0x35}));
+    CHECK(replayed["Device"].get<sdbus::ObjectPath>() == "/org/bluez/hci0/dev_AA_BB_CC_DD_EE_FF");
+    CHECK(replayed["Codec"].get<std::uint8_t>() == 0);
+    CHECK(replayed["Delay"].get<std::uint16_t>() == 150);
+    CHECK(replayed["Offset"].get<std::int16_t>() == -3);
+    CHECK(replayed["Gain"].get<double>() == -1.5);
+    CHECK(replayed["Stamp"].get<std::int64_t>() == -5000000000LL);
+    CHECK(replayed["Links"].get<std::vector<sdbus::ObjectPath>>().size() == 2);
+    auto replayedQos = replayed["QoS"].get<Dict>();
+    CHECK(replayedQos["Interval"].get<std::uint32_t>() == 10000);
+    CHECK(replayedQos["Framing"].get<bool>());
+
+    CHECK(reader.next(call));
+    CHECK(call.method == CallMethod::PropertiesGet);
+    CHECK(call.property == "UUID");
+    CHECK(!reader.next(call));
+
+    std::remove(path.c_str());
+}
+
+void testUnsupportedTypeIsLossy()
+{
+    Dict options{
+        {"mtu", sdbus::Variant(std::uint16_t{185})},
+        {"pair", sdbus::Variant(sdbus::Struct<std::int32_t, std::int32_t>{1, 2})},
+    };
+
+    auto path = capturePath();
+    auto& recorder = CallRecorder::getInstance();
+    CHECK(recorder.open(path, kTargetPaths));
+    recorder.record(CallTarget::Characteristic, CallMethod::ReadValue, {}, &options);
+    recorder.close();
+
+    CaptureReader reader(path);
+    CapturedCall call;
+    CHECK(reader.next(call));
+    CHECK(call.lossy);
+    CHECK(call.options.size() == 2);
+
+    auto replayed = toOptions(call.options);
+    CHECK(replayed.size() == 1);
+    CHECK(replayed["mtu"].get<std::uint16_t>() == 185);
+
+    std::remove(path.c_str());
+}
+} // namespace
+
+int main()
+{
+    Logger::getInstance().setLogToConsole(false);
+
+    testOptionsRoundTrip();
+    testUnsupportedTypeIsLossy();
+
+    return reportFailures();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <iostream>
+
+// Minimal assertion harness shared by the test executables: CHECK() reports
+// and counts a failed condition, main() returns reportFailures().
+inline int gFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+            ++gFailures; \
+        } \
+    } while (0)
+
+inline int reportFailures()
+{
+    if (gFailures)
+        std::cerr << gFailures << " check(s) failed\n";
+    return gFailures ? 1 : 0;
+}
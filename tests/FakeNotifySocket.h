@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Datagram socket standing in for systemd's $NOTIFY_SOCKET; `name` starting
+// with '@' is abstract
+class FakeNotifySocket
+{
+public:
+    explicit FakeNotifySocket(const std::string& name)
+        : name_(name)
+    {
+        fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        timeval tv{1, 0};
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, name.data(), name.size());
+        if (name[0] == '@')
+            addr.sun_path[0] = '\0';
+        else
+            ::unlink(name.c_str());
+        auto len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + name.size());
+        bound_ = ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), len) == 0;
+    }
+
+    ~FakeNotifySocket()
+    {
+        ::close(fd_);
+        if (name_[0] != '@')
+            ::unlink(name_.c_str());
+    }
+
+    FakeNotifySocket(const FakeNotifySocket&) = delete;
+    FakeNotifySocket& operator=(const FakeNotifySocket&) = delete;
+
+    bool bound() const { return bound_; }
+
+    // Waits up to a second for the next datagram; empty on timeout
+    std::string receive()
+    {
+        char buf[256];
+        auto n = ::recv(fd_, buf, sizeof(buf), 0);
+        return n > 0 ? std::string(buf, static_cast<std::size_t>(n)) : std::string{};
+    }
+
+    // True if a datagram is queued. Local datagrams are queued by the time
+    // send() returns, so this does not need to wait.
+    bool pending()
+    {
+        char c;
+        return ::recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT) >= 0;
+    }
+
+private:
+    std::string name_;
+    int fd_{-1};
+    bool bound_{false};
+};
@@ -0,0 +1,135 @@
+// Round-trips MeasurementBatcher output through decodeMeasurementNotification.
+#include "Check.h"
+#include "MeasurementBatch.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace {
+std::vector<MeasurementSample> makeSamples(std::size_t count)
+{
+    std::vector<MeasurementSample> samples;
+    std::uint32_t ts = 1000;
+    std::int32_t milli = 45000;
+    for (std::size_t i = 0; i < count; ++i) {
+        ts += 100 + static_cast<std::uint32_t>(i % 7);
+        milli += static_cast<std::int32_t>(i % 11) * 37 - 180;
+        samples.push_back({ts, milli});
+    }
+    return samples;
+}
+
+// Decodes every batch, checking its size, and appends the samples to `decoded`
+void collect(const std::vector<std::uint8_t>& batch, std::size_t payloadLimit, std::vector<MeasurementSample>& decoded)
+{
+    std::vector<MeasurementSample> samples;
+    std::int8_t exponent = 0;
+    CHECK(batch.size() <= payloadLimit);
+    CHECK(decodeMeasurementNotification(batch.data(), batch.size(), samples, &exponent));
+    CHECK(exponent == -3);
+    decoded.insert(decoded.end(), samples.begin(), samples.end());
+}
+
+void checkEqual(const std::vector<MeasurementSample>& got, const std::vector<MeasurementSample>& want)
+{
+    CHECK(got.size() == want.size());
+    for (std::size_t i = 0; i < got.size() && i < want.size(); ++i) {
+        CHECK(got[i].timestampMs == want[i].timestampMs);
+        CHECK(got[i].mantissa == want[i].mantissa);
+    }
+}
+
+void testRoundTrip(std::size_t mtu)
+{
+    auto samples = makeSamples(1000);
+    MeasurementBatcher batcher(mtu, std::chrono::hours(1));
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::uint8_t> batch;
+    std::vector<MeasurementSample> decoded;
+
+    for (const auto& s : samples) {
+        if (batcher.add(s, now, batch))
+            collect(batch, batcher.payloadLimit(), decoded);
+    }
+    if (batcher.flush(batch))
+        collect(batch, batcher.payloadLimit(), decoded);
+
+    checkEqual(decoded, samples);
+}
+
+void testMtuShrinkSplitsPendingBatch()
+{
+    auto samples = makeSamples(100);
+    MeasurementBatcher batcher(517, std::chrono::hours(1));
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::uint8_t> batch;
+    std::vector<MeasurementSample> decoded;
+
+    for (const auto& s : samples)
+        CHECK(!batcher.add(s, now, batch));
+
+    // A client with the minimum MTU shows up while a large batch is pending
+    while (batcher.changeMtu(23, batch))
+        collect(batch, batcher.payloadLimit(), decoded);
+    if (batcher.flush(batch))
+        collect(batch, batcher.payloadLimit(), decoded);
+
+    checkEqual(decoded, samples);
+}
+
+void testLatencyDeadline()
+{
+    MeasurementBatcher batcher(247, std::chrono::milliseconds(500));
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::uint8_t> batch;
+
+    batcher.add({0, 45000}, now, batch);
+    CHECK(!batcher.poll(now + std::chrono::milliseconds(499), batch));
+    CHECK(batcher.poll(now + std::chrono::milliseconds(500), batch));
+    CHECK(batcher.empty());
+}
+
+void testSingleValue()
+{
+    std::vector<std::uint8_t> data;
+    std::vector<MeasurementSample> decoded;
+    encodeMeasurementValue(-1234, -3, data);
+    CHECK(decodeMeasurementNotification(data.data(), data.size(), decoded));
+    CHECK(decoded.size() == 1 && decoded[0].mantissa == -1234);
+}
+
+void testRejectsMalformed()
+{
+    std::vector<MeasurementSample> decoded;
+
+    // Empty batch
+    std::vector<std::uint8_t> empty{kMeasurementFlagBatch, 0, 0, 0, 0, 0, 0, 0, 0, 0xFD};
+    CHECK(!decodeMeasurementNotification(empty.data(), empty.size(), decoded));
+
+    // Reserved flag bits
+    std::vector<std::uint8_t> reserved{kMeasurementFlagBatch | 0x08, 1, 0, 0, 0, 0, 0, 0, 0, 0xFD};
+    CHECK(!decodeMeasurementNotification(reserved.data(), reserved.size(), decoded));
+
+    // Count promises more samples than the payload holds
+    std::vector<std::uint8_t> truncated{kMeasurementFlagBatch, 3, 0, 0, 0, 0, 0, 0, 0, 0xFD, 100, 2};
+    CHECK(!decodeMeasurementNotification(truncated.data(), truncated.size(), decoded));
+
+    // Trailing bytes after the last sample
+    std::vector<std::uint8_t> trailing{kMeasurementFlagBatch, 1, 0, 0, 0, 0, 0, 0, 0, 0xFD, 100};
+    CHECK(!decodeMeasurementNotification(trailing.data(), trailing.size(), decoded));
+}
+} // namespace
+
+int main()
+{
+    for (std::size_t mtu : {23, 185, 247, 517})
+        testRoundTrip(mtu);
+    testMtuShrinkSplitsPendingBatch();
+    testLatencyDeadline();
+    testSingleValue();
+    testRejectsMalformed();
+
+    return reportFailures();
+}
@@ -0,0 +1,111 @@
+// Checks SystemdNotifier against a local fake $NOTIFY_SOCKET.
+#include "Check.h"
+#include "FakeNotifySocket.h"
+#include "SystemdNotifier.h"
+
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+void setEnv(const char* name, const std::string& value)
+{
+    ::setenv(name, value.c_str(), 1);
+}
+
+void clearEnv()
+{
+    ::unsetenv("NOTIFY_SOCKET");
+    ::unsetenv("WATCHDOG_USEC");
+    ::unsetenv("WATCHDOG_PID");
+}
+
+void testDisabledWithoutSocket()
+{
+    clearEnv();
+    SystemdNotifier notifier;
+    CHECK(!notifier.enabled());
+    CHECK(notifier.watchdogInterval().count() == 0);
+    CHECK(!notifier.ready());
+}
+
+void testPathSocket()
+{
+    std::string path = "/tmp/gatt_notify_test_" + std::to_string(::getpid()) + ".sock";
+    FakeNotifySocket sock(path);
+    CHECK(sock.bound());
+
+    clearEnv();
+    setEnv("NOTIFY_SOCKET", path);
+    setEnv("WATCHDOG_USEC", "2000000");
+    setEnv("WATCHDOG_PID", std::to_string(::getpid()));
+
+    SystemdNotifier notifier;
+    CHECK(notifier.enabled());
+    CHECK(notifier.watchdogInterval().count() == 2000000);
+    CHECK(notifier.ready());
+    CHECK(sock.receive() == "READY=1");
+    CHECK(notifier.watchdog());
+    CHECK(sock.receive() == "WATCHDOG=1");
+    CHECK(notifier.stopping());
+    CHECK(sock.receive() == "STOPPING=1");
+}
+
+void testWatchdogWithoutPid()
+{
+    std::string path = "/tmp/gatt_notify_test_nopid_" + std::to_string(::getpid()) + ".sock";
+    FakeNotifySocket sock(path);
+
+    clearEnv();
+    setEnv("NOTIFY_SOCKET", path);
+    setEnv("WATCHDOG_USEC", "500000");
+
+    SystemdNotifier notifier;
+    CHECK(notifier.watchdogInterval().count() == 500000);
+}
+
+void testWatchdogPidMismatch()
+{
+    std::string path = "/tmp/gatt_notify_test_pid_" + std::to_string(::getpid()) + ".sock";
+    FakeNotifySocket sock(path);
+
+    clearEnv();
+    setEnv("NOTIFY_SOCKET", path);
+    setEnv("WATCHDOG_USEC", "2000000");
+    setEnv("WATCHDOG_PID", std::to_string(::getpid() + 1));
+
+    // The watchdog is meant for another process, but notifications still go out
+    SystemdNotifier notifier;
+    CHECK(notifier.enabled());
+    CHECK(notifier.watchdogInterval().count() == 0);
+    CHECK(notifier.ready());
+    CHECK(sock.receive() == "READY=1");
+}
+
+void testAbstractSocket()
+{
+    std::string name = "@gatt_notify_test_" + std::to_string(::getpid());
+    FakeNotifySocket sock(name);
+    CHECK(sock.bound());
+
+    clearEnv();
+    setEnv("NOTIFY_SOCKET", name);
+
+    SystemdNotifier notifier;
+    CHECK(notifier.enabled());
+    CHECK(notifier.watchdog());
+    CHECK(sock.receive() == "WATCHDOG=1");
+}
+} // namespace
+
+int main()
+{
+    testDisabledWithoutSocket();
+    testPathSocket();
+    testWatchdogWithoutPid();
+    testWatchdogPidMismatch();
+    testAbstractSocket();
+
+    return reportFailures();
+}
@@ -0,0 +1,117 @@
+// Checks that WatchdogGate stops WATCHDOG=1 once the event loop's heartbeats
+// stall, against a local fake $NOTIFY_SOCKET.
+#include "Check.h"
+#include "FakeNotifySocket.h"
+#include "Logger.h"
+#include "WatchdogGate.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+using Clock = WatchdogGate::Clock;
+using std::chrono::milliseconds;
+
+// WATCHDOG_USEC of 200 ms: pings are due every 100 ms
+constexpr const char* kWatchdogUsec = "200000";
+
+std::string socketPath(const char* name)
+{
+    return "/tmp/gatt_watchdog_test_" + std::string(name) + "_" + std::to_string(::getpid()) + ".sock";
+}
+
+void useSocket(const std::string& path, const char* watchdogUsec)
+{
+    ::setenv("NOTIFY_SOCKET", path.c_str(), 1);
+    ::unsetenv("WATCHDOG_PID");
+    if (watchdogUsec)
+        ::setenv("WATCHDOG_USEC", watchdogUsec, 1);
+    else
+        ::unsetenv("WATCHDOG_USEC");
+}
+
+void testPingsWhileHealthy()
+{
+    auto path = socketPath("healthy");
+    FakeNotifySocket sock(path);
+    useSocket(path, kWatchdogUsec);
+
+    SystemdNotifier notifier;
+    const auto t0 = Clock::now();
+    WatchdogGate gate(notifier, t0);
+    CHECK(gate.enabled());
+    CHECK(gate.period() == milliseconds(100));
+
+    // First ping is due right away
+    CHECK(gate.poll(t0, t0));
+    CHECK(sock.receive() == "WATCHDOG=1");
+
+    // Not due yet
+    CHECK(gate.poll(t0 + milliseconds(50), t0 + milliseconds(40)));
+    CHECK(!sock.pending());
+
+    // Due, with a heartbeat inside the interval
+    CHECK(gate.poll(t0 + milliseconds(100), t0 + milliseconds(90)));
+    CHECK(sock.receive() == "WATCHDOG=1");
+}
+
+void testStallWithholdsPings()
+{
+    auto path = socketPath("stall");
+    FakeNotifySocket sock(path);
+    useSocket(path, kWatchdogUsec);
+
+    SystemdNotifier notifier;
+    const auto t0 = Clock::now();
+    const auto lastBeat = t0;
+    WatchdogGate gate(notifier, t0);
+
+    CHECK(gate.poll(t0, lastBeat));
+    CHECK(sock.receive() == "WATCHDOG=1");
+
+    // Heartbeats stop at t0; still within the 200 ms interval
+    CHECK(gate.poll(t0 + milliseconds(150), lastBeat));
+    CHECK(sock.receive() == "WATCHDOG=1");
+
+    // Past the interval: every due ping is withheld while the stall lasts
+    CHECK(!gate.poll(t0 + milliseconds(250), lastBeat));
+    CHECK(!sock.pending());
+    CHECK(!gate.poll(t0 + milliseconds(400), lastBeat));
+    CHECK(!sock.pending());
+    CHECK(!gate.poll(t0 + milliseconds(2000), lastBeat));
+    CHECK(!sock.pending());
+
+    // The loop answers again
+    CHECK(gate.poll(t0 + milliseconds(2100), t0 + milliseconds(2090)));
+    CHECK(sock.receive() == "WATCHDOG=1");
+}
+
+void testDisabledWithoutWatchdog()
+{
+    auto path = socketPath("off");
+    FakeNotifySocket sock(path);
+    useSocket(path, nullptr);
+
+    SystemdNotifier notifier;
+    const auto t0 = Clock::now();
+    WatchdogGate gate(notifier, t0);
+    CHECK(!gate.enabled());
+    CHECK(gate.poll(t0, t0));
+    CHECK(gate.poll(t0 + milliseconds(5000), t0));
+    CHECK(!sock.pending());
+}
+} // namespace
+
+int main()
+{
+    Logger::getInstance().setLogToConsole(false);
+
+    testPingsWhileHealthy();
+    testStallWithholdsPings();
+    testDisabledWithoutWatchdog();
+
+    return reportFailures();
+}
@@ -0,0 +1,243 @@
+// Replays a capture recorded with `GattServer --capture FILE` against a server
+// running on a private bus (`GattServer --bus ADDRESS`) and reports throughput
+// and per-call latency.
+#include "CallCapture.h"
+
+#include <sdbus-c++/sdbus-c++.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* kDefaultDestination = "com.example.GattServer";
+
+struct Options
+{
+    std::string captureFile;
+    std::string busAddress;
+    std::string destination{kDefaultDestination};
+    bool asap{false};
+    std::size_t window{64};
+    std::chrono::milliseconds timeout{5000};
+};
+
+struct Stats
+{
+    std::mutex m;
+    std::condition_variable cv;
+    std::size_t inFlight{0};
+    std::size_t errors{0};
+    std::vector<std::int64_t> latenciesUs;
+};
+
+void usage()
+{
+    std::cerr << "Usage: GattReplay <capture-file> [--bus ADDRESS] [--dest NAME] [--asap] [--window N] [--timeout-ms N]\n"
+              << "  --bus ADDRESS   bus the server runs on (default: session bus)\n"
+              << "  --dest NAME     server bus name (default: " << kDefaultDestination << ")\n"
+              << "  --asap          ignore the recorded pacing and send as fast as possible\n"
+              << "  --window N      maximum calls in flight (default: 64)\n"
+              << "  --timeout-ms N  per-call timeout (default: 5000)\n";
+}
+
+bool parseArgs(int argc, char* argv[], Options& opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bus" && i + 1 < argc)
+            opts.busAddress = argv[++i];
+        else if (arg == "--dest" && i + 1 < argc)
+            opts.destination = argv[++i];
+        else if (arg == "--asap")
+            opts.asap = true;
+        else if (arg == "--window" && i + 1 < argc)
+            opts.window = std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--timeout-ms" && i + 1 < argc)
+            opts.timeout = std::chrono::milliseconds(std::strtol(argv[++i], nullptr, 10));
+        else if (opts.captureFile.empty() && arg[0] != '-')
+            opts.captureFile = arg;
+        else
+            return false;
+    }
+    return !opts.captureFile.empty();
+}
+
+sdbus::MethodCall buildCall(sdbus::IProxy& proxy, const CapturedCall& call)
+{
+    auto msg = proxy.createMethodCall(sdbus::InterfaceName{interfaceNameOf(call.target, call.method)},
+                                      sdbus::MethodName{methodNameOf(call.method)});
+    switch (call.method) {
+        case CallMethod::ReadValue:
+            msg << toOptions(call.options);
+            break;
+        case CallMethod::WriteValue:
+            msg << call.payload << toOptions(call.options);
+            break;
+        case CallMethod::SetConfiguration:
+            msg << sdbus::ObjectPath(call.objectPath) << toOptions(call.options);
+            break;
+        case CallMethod::SelectConfiguration:
+            msg << call.payload;
+            break;
+        case CallMethod::ClearConfiguration:
+            msg << sdbus::ObjectPath(call.objectPath);
+            break;
+        case CallMethod::PropertiesGet:
+            msg << std::string(interfaceNameOf(call.target)) << call.property;
+            break;
+        case CallMethod::PropertiesGetAll:
+            msg << std::string(interfaceNameOf(call.target));
+            break;
+        default:
+            break;
+    }
+    return msg;
+}
+
+std::int64_t percentile(const std::vector<std::int64_t>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    auto idx = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        usage();
+        return 2;
+    }
+
+    CaptureReader reader(opts.captureFile);
+    if (!reader.ok()) {
+        std::cerr << "Not a capture file: " << opts.captureFile << "\n";
+        return 2;
+    }
+
+    std::unique_ptr<sdbus::IConnection> conn;
+    try {
+        conn = opts.busAddress.empty() ? sdbus::createSessionBusConnection()
+                                       : sdbus::createSessionBusConnectionWithAddress(opts.busAddress);
+    } catch (const sdbus::Error& e) {
+        std::cerr << "Failed to connect: [" << e.getName() << "] " << e.getMessage() << "\n";
+        return 2;
+    }
+    conn->enterEventLoopAsync();
+
+    std::array<std::unique_ptr<sdbus::IProxy>, static_cast<std::size_t>(CallTarget::Count)> proxies;
+    for (std::size_t i = 0; i < proxies.size(); ++i) {
+        const auto& path = reader.targetPath(static_cast<CallTarget>(i));
+        if (!path.empty())
+            proxies[i] = sdbus::createProxy(*conn, sdbus::ServiceName{opts.destination}, sdbus::ObjectPath{path});
+    }
+
+    Stats stats;
+    std::size_t sent = 0;
+    std::size_t skipped = 0;
+    std::size_t lossy = 0;
+    const auto timeoutUs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(opts.timeout).count());
+
+    // Timestamps are relative to opening the capture; pacing and the elapsed
+    // time start at the first call rather than replaying the idle time before it
+    std::optional<std::chrono::microseconds> firstTimestamp;
+    std::chrono::microseconds captureSpan{0};
+    auto begin = Clock::now();
+
+    CapturedCall call;
+    while (reader.next(call)) {
+        if (!firstTimestamp) {
+            firstTimestamp = call.timestamp;
+            begin = Clock::now();
+        }
+        captureSpan = call.timestamp - *firstTimestamp;
+        auto& proxy = proxies[static_cast<std::size_t>(call.target)];
+        if (!proxy) {
+            ++skipped;
+            continue;
+        }
+        // Sent without the options the capture could not encode, but the run fails
+        if (call.lossy)
+            ++lossy;
+
+        if (!opts.asap)
+            std::this_thread::sleep_until(begin + captureSpan);
+
+        {
+            std::unique_lock<std::mutex> lk(stats.m);
+            stats.cv.wait(lk, [&] { return stats.inFlight < opts.window; });
+            ++stats.inFlight;
+        }
+
+        auto sentAt = Clock::now();
+        try {
+            proxy->callMethodAsync(buildCall(*proxy, call), [&stats, sentAt](sdbus::MethodReply, std::optional<sdbus::Error> e) {
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sentAt).count();
+                std::lock_guard<std::mutex> lk(stats.m);
+                stats.latenciesUs.push_back(us);
+                if (e)
+                    ++stats.errors;
+                --stats.inFlight;
+                stats.cv.notify_all();
+            }, timeoutUs);
+            ++sent;
+        } catch (const sdbus::Error& e) {
+            std::cerr << methodNameOf(call.method) << ": [" << e.getName() << "] " << e.getMessage() << "\n";
+            std::lock_guard<std::mutex> lk(stats.m);
+            ++stats.errors;
+            --stats.inFlight;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lk(stats.m);
+        stats.cv.wait_for(lk, opts.timeout, [&] { return stats.inFlight == 0; });
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    conn->leaveEventLoop();
+
+    std::vector<std::int64_t> latencies;
+    std::size_t errors = 0;
+    std::size_t unanswered = 0;
+    {
+        std::lock_guard<std::mutex> lk(stats.m);
+        latencies = stats.latenciesUs;
+        errors = stats.errors;
+        unanswered = stats.inFlight;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "Replayed " << sent << " calls (" << (opts.asap ? "as fast as possible" : "original pacing")
+              << ", capture span " << std::fixed << std::setprecision(3) << captureSpan.count() / 1e6 << "s)\n"
+              << "  elapsed:     " << elapsed << "s\n"
+              << "  throughput:  " << std::setprecision(1) << (elapsed > 0 ? sent / elapsed : 0.0) << " calls/s\n"
+              << "  latency us:  p50 " << percentile(latencies, 0.50)
+              << "  p90 " << percentile(latencies, 0.90)
+              << "  p99 " << percentile(latencies, 0.99)
+              << "  max " << (latencies.empty() ? 0 : latencies.back()) << "\n"
+              << "  errors:      " << errors << "\n";
+    if (skipped)
+        std::cout << "  skipped:     " << skipped << " (no object path in capture)\n";
+    if (unanswered)
+        std::cout << "  unanswered:  " << unanswered << "\n";
+    if (lossy)
+        std::cout << "  lossy:       " << lossy << " (options of a type the capture could not encode)\n";
+
+    return errors == 0 && unanswered == 0 && lossy == 0 ? 0 : 1;
+}